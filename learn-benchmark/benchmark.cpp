@@ -0,0 +1,20 @@
+﻿#include <string_view>
+
+#include "pool_benchmark.hpp"
+#include "blob_benchmark.hpp"
+#include "static_group_benchmark.hpp"
+
+/// <summary>
+/// 用法：learn-benchmark [名称]。不给名称时运行全部。
+/// </summary>
+int main(int argc, char** argv)
+{
+	std::string_view which = argc > 1 ? argv[1] : "";
+	if (which.empty() || which == "pool")
+		benchmark::run_pool_benchmark();
+	if (which.empty() || which == "blob")
+		benchmark::run_blob_benchmark();
+	if (which.empty() || which == "static_group")
+		benchmark::run_static_group_benchmark();
+	return 0;
+}
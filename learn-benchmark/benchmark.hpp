@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+namespace benchmark
+{
+	/// <summary>
+	/// 执行 f 并返回耗时（微秒）。
+	/// </summary>
+	template <typename function_t>
+	inline double elapsed_microseconds(function_t&& f)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+	}
+	/// <summary>
+	/// 执行 f 共 repeat 次，返回单次的平均耗时（微秒）。
+	/// </summary>
+	template <typename function_t>
+	inline double average_microseconds(int repeat, function_t&& f)
+	{
+		return elapsed_microseconds([&]
+			{
+				for (int i = 0; i < repeat; i++)
+					f();
+			}) / repeat;
+	}
+}
@@ -0,0 +1,83 @@
+﻿#pragma once
+
+#include <string>
+#include <filesystem>
+
+#include "utils/direct_ui.hpp"
+#include "utils/scene_blob.hpp"
+#include "benchmark.hpp"
+
+namespace benchmark
+{
+	/// <summary>
+	/// 启动时构造 count 个节点的控件树：从场景描述文件载入并实例化，与逐个调用 build_dep_widget 比较。
+	/// </summary>
+	inline void run_blob_benchmark(int count = 5000, int repeat = 20)
+	{
+		using namespace direct_ui;
+		auto fill = layout_params{ .left = 0, .top = 0, .right = 0, .bottom = 0 };
+		auto path = (std::filesystem::temp_directory_path() / "learn-benchmark.blob").string();
+		{
+			scene_blob_builder builder;
+			auto root = builder.add("group");
+			builder.set(root, scene_key::layout, static_cast<int>(scene_layout_kind::vertical_stack));
+			builder.set(root, fill);
+			for (int i = 0; i < count; i++)
+			{
+				auto r = builder.add("rect", root, 0, 0, 10, 4);
+				builder.set(r, scene_key::brush_color, color(0xff000000u | i));
+			}
+			auto b = builder.add("button", root, 0, 0, 80, 30);
+			builder.name(b, "ok");
+			builder.set(b, scene_key::text, std::u8string_view(u8"OK"));
+			builder.save(path);
+		}
+
+		scene_factory factory;
+		auto new_scene = [&]
+		{
+			auto s = factory.build_soft_scene(800, 600);
+			s->set_manual_update(true);
+			s->contents->set_layout(std::make_shared<anchor_layout>());
+			return s;
+		};
+		// 两种方式交替执行，避免先后顺序带来的内存预热差异。
+		double load{}, instantiation{}, imperative{};
+		for (int i = 0; i < repeat; i++)
+		{
+			{
+				auto s = new_scene();
+				std::optional<scene_blob> blob;
+				load += elapsed_microseconds([&] { blob.emplace(scene_blob::load(path)); });
+				instantiation += elapsed_microseconds([&] { instantiate(*s, *s->contents, *blob); });
+			}
+			{
+				auto s = new_scene();
+				imperative += elapsed_microseconds([&]
+					{
+						auto root = s->build_dep_widget<group>();
+						s->contents->widgets.push_back(root);
+						root->set_layout(std::make_shared<stack_layout>(stack_layout::orientation::vertical));
+						root->set_layout_params(fill);
+						for (int i = 0; i < count; i++)
+						{
+							auto r = s->build_dep_widget<rect>();
+							root->widgets.push_back(r);
+							r->resize(10, 4);
+							r->brush_color = color(0xff000000u | i);
+						}
+						auto b = s->build_dep_widget<button>();
+						root->widgets.push_back(b);
+						b->resize(80, 30);
+						b->caption = u8"OK";
+					});
+			}
+		}
+		std::filesystem::remove(path);
+
+		std::printf("blob: %d nodes, average of %d\n", count + 2, repeat);
+		std::printf("  blob        load %9.1f us  instantiate %9.1f us  total %9.1f us\n",
+			load / repeat, instantiation / repeat, (load + instantiation) / repeat);
+		std::printf("  imperative                             total %9.1f us\n", imperative / repeat);
+	}
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "utils/direct_ui.hpp"
+#include "benchmark.hpp"
+
+namespace benchmark
+{
+	/// <summary>
+	/// 构造并销毁由 count 个矩形组成的树，比较控件池与逐个 std::make_shared 的耗时与向系统申请内存的次数。
+	/// 两种方式在同一个场景中交替执行 repeat 次取平均，比较的是反复重建时的稳定状态；
+	/// 第一次构建另行给出，其中包括池向系统申请大块的开销。
+	/// </summary>
+	inline void run_pool_benchmark(size_t count = 10000, int repeat = 10)
+	{
+		using namespace direct_ui;
+		scene_factory factory;
+		auto s = factory.build_soft_scene(800, 600);
+		s->set_manual_update(true);
+		auto build_pooled = [&]
+			{
+				auto root = s->build_dep_widget<group>();
+				root->widgets.reserve(count);
+				for (size_t i = 0; i < count; i++)
+					root->widgets.push_back(s->build_dep_widget<rect>());
+				return root;
+			};
+		auto build_plain = [&]
+			{
+				auto root = std::make_shared<group>();
+				root->widgets.reserve(count);
+				for (size_t i = 0; i < count; i++)
+					root->widgets.push_back(std::make_shared<rect>());
+				return root;
+			};
+
+		std::shared_ptr<group> root;
+		auto before = s->widget_pool_statistics();
+		double first_build = elapsed_microseconds([&] { root = build_pooled(); });
+		auto after = s->widget_pool_statistics();
+		root.reset();
+
+		double pooled_build{}, pooled_teardown{}, plain_build{}, plain_teardown{};
+		for (int round = 0; round < repeat; round++)
+		{
+			pooled_build += elapsed_microseconds([&] { root = build_pooled(); });
+			pooled_teardown += elapsed_microseconds([&] { root.reset(); });
+			plain_build += elapsed_microseconds([&] { root = build_plain(); });
+			plain_teardown += elapsed_microseconds([&] { root.reset(); });
+		}
+
+		std::printf("pool: %zu widgets, average of %d\n", count, repeat);
+		std::printf("  pooled      first build %9.1f us  allocations %zu  system allocations %zu\n",
+			first_build, after.allocations - before.allocations,
+			(after.slabs - before.slabs) + (after.large_allocations - before.large_allocations));
+		std::printf("  pooled      build %9.1f us  teardown %9.1f us\n", pooled_build / repeat, pooled_teardown / repeat);
+		std::printf("  make_shared build %9.1f us  teardown %9.1f us  system allocations %zu\n",
+			plain_build / repeat, plain_teardown / repeat, count + 1);
+	}
+}
@@ -0,0 +1,78 @@
+﻿#pragma once
+
+#include <memory>
+
+#include "utils/direct_ui.hpp"
+#include "utils/static_group.hpp"
+#include "unpainted_button.hpp"
+#include "exit_button.hpp"
+#include "icon_button.hpp"
+#include "word_pad.hpp"
+#include "benchmark.hpp"
+
+namespace benchmark
+{
+	/// <summary>
+	/// 同一组子控件分别放在 static_group 与普通 group 中，比较每帧合成整棵树并做 8 次命中测试的耗时。
+	/// 每帧都使子控件失效，使 on_paint 参与计时。
+	/// </summary>
+	inline void run_static_group_benchmark(int frames = 20000)
+	{
+		using namespace direct_ui;
+		using fixed_group = static_group<rect, button, icon_button, exit_button, word_pad, rect, rect, rect>;
+		scene_factory factory;
+		auto s = factory.build_soft_scene(400, 300);
+		s->set_manual_update(true);
+
+		auto r = s->build_dep_widget<rect>();
+		auto b = s->build_dep_widget<button>();
+		auto ib = s->build_dep_widget<icon_button>();
+		auto eb = s->build_dep_widget<exit_button>();
+		auto wp = s->build_dep_widget<word_pad>();
+		auto r1 = s->build_dep_widget<rect>(), r2 = s->build_dep_widget<rect>(), r3 = s->build_dep_widget<rect>();
+		r->brush_color = color(0xff0000, 255);
+		b->caption = u8"OK";
+		wp->word = u8"hi";
+
+		auto fixed = s->build_dep_widget<fixed_group>();
+		fixed->assign(r, b, ib, eb, wp, r1, r2, r3);
+		fixed->resize(400, 300);
+		real x{};
+		for (const auto& w : fixed->widgets)
+		{
+			to_logic_ref(w)->move(x, 0);
+			to_logic_ref(w)->resize(30, 30);
+			x += 40;
+		}
+		auto plain = s->build_dep_widget<group>();
+		plain->resize(400, 300);
+
+		auto measure = [&](const std::shared_ptr<dep_widget_base>& root, const logic_group& g)
+		{
+			s->contents->widgets = { root };
+			s->on_paint();
+			display_list dl;
+			size_t hits{};
+			double ret = average_microseconds(frames, [&]
+				{
+					for (const auto& w : g.widgets)
+						to_logic_ref(w)->invalidate();
+					dl.clear();
+					s->contents->on_compose(dl);
+					for (int k = 0; k < 8; k++)
+						hits += static_cast<bool>(g.hittest(static_cast<real>(k * 40 + 5), 5));
+				});
+			return std::make_pair(ret, hits);
+		};
+		auto [static_time, static_hits] = measure(fixed, *fixed);
+		// 普通组在静态组之后取得同样的子控件，两者不同时持有。
+		plain->widgets = fixed->widgets;
+		s->contents->widgets.clear();
+		fixed.reset();
+		auto [virtual_time, virtual_hits] = measure(plain, *plain);
+
+		std::printf("static_group: 8 children, average of %d frames (compose + 8 hit tests)\n", frames);
+		std::printf("  static  %7.3f us  hits %zu\n", static_time, static_hits);
+		std::printf("  virtual %7.3f us  hits %zu\n", virtual_time, virtual_hits);
+	}
+}
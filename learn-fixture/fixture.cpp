@@ -5,6 +5,7 @@
 #include "utils/window.hpp"
 #include "utils/direct_ui.hpp"
 #include "utils/direct_ui_window.hpp"
+#include "utils/static_group.hpp"
 
 #include "exit_button.hpp"
 #include "icon_button.hpp"
@@ -54,21 +55,26 @@ class fixture_window final : public dui_window
 		bottom(wa.bottom - dpi(16));
 		top(wa.bottom - dpi(200));
 
+		// 各层都用锚定布局：背景与内部分组铺满，按钮贴边。窗口尺寸变化时由布局重新放置。
+		auto fill = layout_params{ .left = 0, .top = 0, .right = 0, .bottom = 0 };
+		s->contents->set_layout(std::make_shared<anchor_layout>());
+
 		vessel_1 = s->build_dep_widget<vessel>();
 		s->contents->widgets.push_back(vessel_1);
-		vessel_1->resize(s->cx, s->cy);
+		vessel_1->set_layout(std::make_shared<anchor_layout>());
+		vessel_1->set_layout_params(fill);
 
 		auto bg_rect = s->build_dep_widget<rect>();
 		vessel_1->widgets.push_back(bg_rect);
-		bg_rect->move(0, 0);
-		bg_rect->resize(s->cx, s->cy);
+		bg_rect->set_layout_params(fill);
 		bg_rect->brush_color = color(247u, 228u, 172u);
 
-		group_1 = s->build_dep_widget<group>();
+		group_1 = s->build_dep_widget<static_group<word_pad>>();
 		vessel_1->widgets.push_back(group_1);
 		vessel_1->inner_group = group_1;
-		group_1->move(0, 0);
-		group_1->resize(s->cx, s->cy);
+		group_1->cached_layer = true;
+		group_1->set_layout(std::make_shared<anchor_layout>());
+		group_1->set_layout_params(fill);
 
 		exit_button_1 = s->build_dep_widget<exit_button>();
 		vessel_1->widgets.push_back(exit_button_1);
@@ -76,26 +82,25 @@ class fixture_window final : public dui_window
 		{
 			PostMessageW(this->hwnd, WM_QUIT, NULL, NULL);
 		};
-		exit_button_1->move(8, 8);
+		exit_button_1->set_layout_params({ .left = 8, .top = 8 });
 
 		option_button_1 = s->build_dep_widget<icon_button>();
 		vessel_1->widgets.push_back(option_button_1);
 		option_button_1->icon = 0xe700;
-		option_button_1->move(32, 8);
+		option_button_1->set_layout_params({ .left = 32, .top = 8 });
 		option_button_1->set_visible(false);
 		vessel_1->hover_to_show.push_back(option_button_1);
 
 		option_button_2 = s->build_dep_widget<icon_button>();
 		vessel_1->widgets.push_back(option_button_2);
 		option_button_2->icon = 0xe783;
-		option_button_2->move(vessel_1->cx - option_button_2->cx - 8, 8);
+		option_button_2->set_layout_params({ .top = 8, .right = 8 });
 		option_button_2->set_visible(false);
 		vessel_1->hover_to_show.push_back(option_button_2);
 
 		word_pad_1 = s->build_dep_widget<word_pad>();
-		group_1->widgets.push_back(word_pad_1);
-		word_pad_1->move(0, 0);
-		word_pad_1->resize(s->cx, s->cy);
+		group_1->assign(word_pad_1);
+		word_pad_1->set_layout_params(fill);
 
 		return TRUE;
 	}
@@ -110,7 +115,7 @@ private:
 	std::shared_ptr<icon_button> option_button_1;
 	std::shared_ptr<icon_button> option_button_2;
 
-	std::shared_ptr<group> group_1;
+	std::shared_ptr<static_group<word_pad>> group_1;
 	std::shared_ptr<word_pad> word_pad_1;
 
 public:
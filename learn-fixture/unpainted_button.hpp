@@ -39,7 +39,6 @@ namespace direct_ui
 
 		friend class dep_widget<logic_unpainted_button>;
 	};
-#if _MSVC_LANG
 	template <>
 	class dep_widget<logic_unpainted_button> : virtual public logic_unpainted_button, virtual public dep_widget_base
 	{
@@ -47,5 +46,4 @@ namespace direct_ui
 	};
 	using unpainted_button = dep_widget<logic_unpainted_button>;
 	static_assert(has_implimented_dep_widget<logic_unpainted_button>);
-#endif
 }
\ No newline at end of file
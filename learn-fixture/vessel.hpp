@@ -12,33 +12,36 @@ namespace direct_ui
 	private:
 		static constexpr real para_rate = 0.1;
 		bool is_mouse_hover{};
-		real para_x{}, para_y{};
+		tween para_x{ 0, 75 }, para_y{ 0, 75 };
 	private:
 		real mouse_x{}, mouse_y{};
+		// 布局给内部分组的位置。视差偏移叠加在其上，重新排列时不会被布局抵消。
+		real inner_x{}, inner_y{};
+		void place_inner_group()
+		{
+			if (!inner_group.expired())
+				inner_group.lock()->move(inner_x + para_x.value(), inner_y + para_y.value());
+		}
+	protected:
+		virtual void on_arrange(layout_size size) override
+		{
+			logic_group::on_arrange(size);
+			if (!get_layout() || inner_group.expired())
+				return;
+			auto g = inner_group.lock();
+			inner_x = g->x();
+			inner_y = g->y();
+			place_inner_group();
+		}
 	public:
 		virtual void on_update(std::chrono::high_resolution_clock::duration elapsed) override
 		{
-			logic_group::on_update(elapsed);
-			auto sec = std::chrono::duration_cast<std::chrono::duration<real>>(elapsed);
-			real dt = sec.count();
-			{
-				real para_x_target = is_mouse_hover * (cx / 2 - mouse_x) * para_rate;
-				constexpr real speed = 75;
-				real step = (para_x_target > para_x ? 1 : -1) * speed * dt;
-				para_x += step;
-				if (std::abs(para_x - para_x_target) > speed * dt)
-					require_update();
-			}
-			{
-				real para_y_target = is_mouse_hover * (cy / 2 - mouse_y) * para_rate;
-				constexpr real speed = 75;
-				real step = (para_y_target > para_y ? 1 : -1) * speed * dt;
-				para_y += step;
-				if (std::abs(para_y - para_y_target) > speed * dt)
-					require_update();
-			}
-			if (!inner_group.expired())
-				inner_group.lock()->move(para_x, para_y);
+			para_x.animate_to(*this, is_mouse_hover * (cx() / 2 - mouse_x) * para_rate);
+			para_y.animate_to(*this, is_mouse_hover * (cy() / 2 - mouse_y) * para_rate);
+			// 视差需要每帧移动内部分组，动画进行时继续请求更新。
+			if (para_x.is_active() || para_y.is_active())
+				require_update();
+			place_inner_group();
 		}
 		virtual void on_mouse_hover() override
 		{
@@ -76,12 +79,10 @@ namespace direct_ui
 
 		friend class dep_widget<logic_vessel>;
 	};
-#if _MSVC_LANG
 	template <>
 	class dep_widget<logic_vessel> : virtual public logic_vessel, virtual public dep_widget<logic_group>
 	{
 	};
 	using vessel = dep_widget<logic_vessel>;
 	static_assert(has_implimented_dep_widget<logic_vessel>);
-#endif
 }
\ No newline at end of file
@@ -236,4 +236,19 @@ public:
 		return ret;
 	}
 };
+#else
+/// <summary>
+/// 从 UTF-8 转换到 wstring（wchar_t 为 UTF-32 的平台）。
+/// </summary>
+template <>
+class code_conv<char8_t, wchar_t>
+{
+	static_assert(sizeof(wchar_t) == sizeof(char32_t));
+public:
+	[[nodiscard]] static std::wstring convert(std::u8string_view src)
+	{
+		auto t = code_conv<char8_t, char32_t>::convert(src);
+		return std::wstring(t.begin(), t.end());
+	}
+};
 #endif
\ No newline at end of file
@@ -0,0 +1,298 @@
+﻿#pragma once
+
+#if _MSVC_LANG
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+
+#include <Windows.h>
+#undef min
+#undef max
+#include <d2d1.h>
+#include <d2d1_1.h>
+#include <dwrite.h>
+#pragma comment(lib, "d2d1.lib")
+#pragma comment(lib, "dwrite.lib")
+
+#include "render_backend.hpp"
+#include "resource_cache.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 将 COM 指针包装为释放时调用 Release 的共享指针。
+	/// </summary>
+	template <typename T>
+	inline std::shared_ptr<T> make_com_shared(T* p)
+	{
+		if (!p)
+			return {};
+		return std::shared_ptr<T>(p, [](T* p) { p->Release(); });
+	}
+
+	/// <summary>
+	/// 文字格式只依赖 DirectWrite 工厂，同一工厂创建的场景可以共享。
+	/// </summary>
+	using d2d_text_format_cache = resource_cache<text_format_key, IDWriteTextFormat, text_format_hash, text_format_equal>;
+	/// <summary>
+	/// 排版结果同样只依赖工厂，与文字格式一起按工厂共享。
+	/// </summary>
+	using d2d_text_layout_cache = text_layout_cache<IDWriteTextLayout>;
+	/// <summary>
+	/// 画刷依赖渲染目标，每个后端一份。
+	/// </summary>
+	using d2d_brush_cache = resource_cache<std::uint32_t, ID2D1SolidColorBrush>;
+
+	/// <summary>
+	/// Direct2D 渲染后端（仅 Windows）。持有并释放窗口渲染目标。
+	/// </summary>
+	class d2d_backend : public render_backend
+	{
+		IDWriteFactory* pDWriteFactory;
+		ID2D1HwndRenderTarget* pHwndRenderTarget;
+		ID2D1RenderTarget* pRenderTarget;
+		std::unordered_map<unsigned, ID2D1BitmapRenderTarget*> layers;
+		std::vector<ID2D1RenderTarget*> targets;
+		std::shared_ptr<d2d_text_format_cache> text_formats;
+		std::shared_ptr<d2d_text_layout_cache> text_layouts;
+		d2d_brush_cache brushes{ 256 };
+		ID2D1SolidColorBrush* instance_brush{}; // 批量绘制时逐个改色，不经过画刷缓存。
+
+	public:
+		d2d_backend(IDWriteFactory* pDWriteFactory, ID2D1HwndRenderTarget* pHwndRenderTarget,
+			std::shared_ptr<d2d_text_format_cache> text_formats = std::make_shared<d2d_text_format_cache>(64),
+			std::shared_ptr<d2d_text_layout_cache> text_layouts = std::make_shared<d2d_text_layout_cache>(1024, 1 << 20)) :
+			pDWriteFactory(pDWriteFactory),
+			pHwndRenderTarget(pHwndRenderTarget),
+			pRenderTarget(pHwndRenderTarget),
+			text_formats(std::move(text_formats)),
+			text_layouts(std::move(text_layouts))
+		{
+		}
+		d2d_backend(const d2d_backend&) = delete;
+		d2d_backend(d2d_backend&&) = delete;
+		d2d_backend& operator=(const d2d_backend&) = delete;
+		d2d_backend& operator=(d2d_backend&&) = delete;
+		~d2d_backend()
+		{
+			brushes.clear();
+			if (instance_brush)
+				instance_brush->Release();
+			for (auto& [id, layer] : layers)
+				layer->Release();
+			if (pHwndRenderTarget)
+				pHwndRenderTarget->Release();
+		}
+
+	public:
+		virtual void resize(int width, int height, int dpi) override
+		{
+			pHwndRenderTarget->Resize(D2D1::SizeU(width, height));
+			pHwndRenderTarget->SetDpi(static_cast<FLOAT>(dpi), static_cast<FLOAT>(dpi));
+		}
+		virtual void begin_draw() override
+		{
+			pRenderTarget->BeginDraw();
+		}
+		virtual void end_draw() override
+		{
+			pRenderTarget->EndDraw();
+		}
+		virtual void clear(const color& c) override
+		{
+			pRenderTarget->Clear(c);
+		}
+
+	public:
+		virtual void set_transform(const matrix& m) override
+		{
+			pRenderTarget->SetTransform(m);
+		}
+		virtual void push_clip(real left, real top, real right, real bottom) override
+		{
+			pRenderTarget->PushAxisAlignedClip(D2D1::RectF(left, top, right, bottom), D2D1_ANTIALIAS_MODE_ALIASED);
+		}
+		virtual void pop_clip() override
+		{
+			pRenderTarget->PopAxisAlignedClip();
+		}
+		virtual void fill_rect(real left, real top, real right, real bottom, const color& brush) override
+		{
+			pRenderTarget->FillRectangle(D2D1::RectF(left, top, right, bottom), get_brush(brush).get());
+		}
+		virtual void draw_rect(real left, real top, real right, real bottom, const color& brush, real stroke) override
+		{
+			pRenderTarget->DrawRectangle(D2D1::RectF(left, top, right, bottom), get_brush(brush).get(), stroke);
+		}
+		virtual void fill_ellipse(real x, real y, real rx, real ry, const color& brush) override
+		{
+			pRenderTarget->FillEllipse(D2D1::Ellipse(D2D1::Point2F(x, y), rx, ry), get_brush(brush).get());
+		}
+		virtual void fill_circles(std::span<const circle_instance> circles) override
+		{
+			if (!instance_brush && FAILED(pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0, 0, 0, 0), &instance_brush)))
+				throw std::runtime_error("Fail to CreateSolidColorBrush.");
+			packed_color current{};
+			for (size_t i = 0; i < circles.size(); i++)
+			{
+				const auto& c = circles[i];
+				if (!i || c.brush != current)
+				{
+					instance_brush->SetColor(c.brush.to_color());
+					current = c.brush;
+				}
+				pRenderTarget->FillEllipse(D2D1::Ellipse(D2D1::Point2F(c.x, c.y), c.r, c.r), instance_brush);
+			}
+		}
+		virtual void draw_text(std::wstring_view str, const text_format& format,
+			real left, real top, real right, real bottom, const color& brush) override
+		{
+			auto layout = get_text_layout(str, format, right - left, bottom - top);
+			if (!layout)
+				return;
+			pRenderTarget->DrawTextLayout(D2D1::Point2F(left, top), layout.get(), get_brush(brush).get());
+		}
+		virtual text_metrics measure_text(std::wstring_view str, const text_format& format,
+			real max_width, real max_height) override
+		{
+			auto layout = get_text_layout(str, format, max_width, max_height);
+			DWRITE_TEXT_METRICS metrics{};
+			if (!layout || FAILED(layout->GetMetrics(&metrics)))
+				return {};
+			DWRITE_LINE_METRICS line{};
+			UINT32 line_count{};
+			layout->GetLineMetrics(&line, 1, &line_count);
+			return { metrics.widthIncludingTrailingWhitespace, metrics.height, line.baseline };
+		}
+
+	public:
+		virtual cache_statistics resource_statistics() const override
+		{
+			auto b = brushes.statistics();
+			auto t = text_formats->statistics();
+			auto l = text_layouts->statistics();
+			return { b.hits + t.hits + l.hits, b.misses + t.misses + l.misses,
+				b.evictions + t.evictions + l.evictions, b.entries + t.entries + l.entries,
+				b.bytes + t.bytes + l.bytes };
+		}
+		cache_statistics brush_statistics() const
+		{
+			return brushes.statistics();
+		}
+		cache_statistics text_format_statistics() const
+		{
+			return text_formats->statistics();
+		}
+		cache_statistics text_layout_statistics() const
+		{
+			return text_layouts->statistics();
+		}
+
+	private:
+		d2d_brush_cache::handle get_brush(const color& c)
+		{
+			return brushes.get(color_key(c), [&]
+				{
+					ID2D1SolidColorBrush* brush{};
+					pRenderTarget->CreateSolidColorBrush(c, &brush);
+					return make_com_shared(brush);
+				});
+		}
+		d2d_text_format_cache::handle get_text_format(const text_format& format)
+		{
+			return text_formats->get(format, [&]
+				{
+					std::wstring family(format.family);
+					IDWriteTextFormat* text_format{};
+					pDWriteFactory->CreateTextFormat(family.c_str(), nullptr,
+						static_cast<DWRITE_FONT_WEIGHT>(format.weight),
+						DWRITE_FONT_STYLE_NORMAL,
+						DWRITE_FONT_STRETCH_NORMAL,
+						format.size,
+						L"",
+						&text_format);
+					if (text_format)
+					{
+						text_format->SetTextAlignment(
+							format.align == text_align::leading ? DWRITE_TEXT_ALIGNMENT_LEADING :
+							format.align == text_align::trailing ? DWRITE_TEXT_ALIGNMENT_TRAILING :
+							DWRITE_TEXT_ALIGNMENT_CENTER);
+						text_format->SetParagraphAlignment(
+							format.paragraph_align == text_align::leading ? DWRITE_PARAGRAPH_ALIGNMENT_NEAR :
+							format.paragraph_align == text_align::trailing ? DWRITE_PARAGRAPH_ALIGNMENT_FAR :
+							DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+					}
+					return make_com_shared(text_format);
+				});
+		}
+		d2d_text_layout_cache::handle get_text_layout(std::wstring_view str, const text_format& format,
+			real width, real height)
+		{
+			return text_layouts->get(text_layout_view(str, format, width, height), [&]
+				{
+					std::shared_ptr<IDWriteTextLayout> ret;
+					auto text_format = get_text_format(format);
+					if (!text_format)
+						return ret;
+					IDWriteTextLayout* layout{};
+					pDWriteFactory->CreateTextLayout(str.data(), static_cast<UINT32>(str.length()),
+						text_format.get(), width, height, &layout);
+					return make_com_shared(layout);
+				}, [&](const IDWriteTextLayout&)
+				{
+					// DirectWrite 不公开排版对象的大小，按字符数粗略估计。
+					return 512 + str.length() * 64;
+				});
+		}
+
+	public:
+		virtual void begin_layer(unsigned layer, real width, real height) override
+		{
+			auto& l = layers[layer];
+			if (l)
+			{
+				auto size = l->GetSize();
+				if (size.width != width || size.height != height)
+				{
+					l->Release();
+					l = nullptr;
+				}
+			}
+			if (!l && FAILED(pHwndRenderTarget->CreateCompatibleRenderTarget(D2D1::SizeF(width, height), &l)))
+				throw std::runtime_error("Fail to CreateCompatibleRenderTarget.");
+			targets.push_back(pRenderTarget);
+			pRenderTarget = l;
+			pRenderTarget->BeginDraw();
+			pRenderTarget->Clear(D2D1::ColorF(0, 0, 0, 0));
+		}
+		virtual void end_layer() override
+		{
+			if (targets.empty())
+				return;
+			pRenderTarget->EndDraw();
+			pRenderTarget = targets.back();
+			targets.pop_back();
+		}
+		virtual void draw_layer(unsigned layer, real width, real height) override
+		{
+			auto it = layers.find(layer);
+			if (it == layers.end() || it->second == pRenderTarget)
+				return;
+			ID2D1Bitmap* bitmap{};
+			if (FAILED(it->second->GetBitmap(&bitmap)))
+				return;
+			pRenderTarget->DrawBitmap(bitmap, D2D1::RectF(0, 0, width, height));
+			bitmap->Release();
+		}
+		virtual void release_layer(unsigned layer) override
+		{
+			auto it = layers.find(layer);
+			if (it == layers.end() || it->second == pRenderTarget)
+				return;
+			it->second->Release();
+			layers.erase(it);
+		}
+	};
+}
+#endif
@@ -15,20 +15,29 @@
 #include <optional>
 #include <concepts>
 #include <ranges>
+#include <stdexcept>
+#include <map>
+#include <algorithm>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
 
 #include "lock_view.hpp"
 #include "code_conv.hpp"
-
-#if _MSVC_LANG
-#include <Windows.h>
-#undef min
-#undef max
-#include <d2d1.h>
-#include <d2d1_1.h>
-#include <dwrite.h>
-#pragma comment(lib, "d2d1.lib")
-#pragma comment(lib, "dwrite.lib")
-#endif
+#include "direct_ui_types.hpp"
+#include "display_list.hpp"
+#include "render_backend.hpp"
+#include "soft_backend.hpp"
+#include "d2d_backend.hpp"
+#include "widget_pool.hpp"
+#include "tween.hpp"
+#include "event_log.hpp"
+#include "trace.hpp"
+#include "thread_pool.hpp"
+#include "render_pipeline.hpp"
+#include "layout.hpp"
+#include "property.hpp"
+#include "frame_governor.hpp"
 
 template <typename T>
 class reversed : public std::bidirectional_iterator_tag
@@ -53,11 +62,12 @@ public:
 
 class timer
 {
-	bool exit{};
+	std::atomic<bool> exit{};
 	std::atomic<bool> prompt{};
 	std::atomic<bool> disabled_once{};
 	std::condition_variable cv;
-	std::chrono::high_resolution_clock::duration elapse{};
+	// set 与 kill 可能从多个线程调用。
+	std::atomic<std::chrono::high_resolution_clock::duration> elapse{};
 	std::function<void()> callback;
 
 	void thread_routine()
@@ -68,9 +78,9 @@ class timer
 			std::unique_lock<std::mutex> lck(mtx);
 			cv.wait(lck, [&]()->bool
 				{
-					return elapse.count() || prompt || exit;
+					return elapse.load().count() || prompt || exit;
 				});
-			cv.wait_for(lck, elapse, [&]()->bool
+			cv.wait_for(lck, elapse.load(), [&]()->bool
 				{
 					return prompt || exit;
 				});
@@ -78,7 +88,7 @@ class timer
 			if (exit)
 				break;
 
-			if (elapse.count())
+			if (elapse.load().count())
 			{
 				if (disabled_once)
 					disabled_once = false;
@@ -94,9 +104,7 @@ public:
 	}
 	~timer()
 	{
-		exit = true;
-		cv.notify_one();
-		timer_thread.join();
+		stop();
 	}
 	timer(const timer&) = delete;
 	timer(timer&&) = delete;
@@ -114,86 +122,52 @@ public:
 	}
 	void kill()
 	{
-		elapse = elapse.zero();
+		elapse = std::chrono::high_resolution_clock::duration::zero();
 		prompt = true;
 		cv.notify_one();
 	}
+	/// <summary>
+	/// 结束计时器线程并等待正在执行的回调返回。此后 set 不再触发回调。
+	/// </summary>
+	void stop()
+	{
+		exit = true;
+		cv.notify_one();
+		if (timer_thread.joinable())
+			timer_thread.join();
+	}
 };
 
 namespace direct_ui
 {
-	using real = float;
-	class color
-	{
-	public:
-		real r{};
-		real g{};
-		real b{};
-		real a{ 1 };
-	public:
-		static constexpr unsigned red_shift = 16;
-		static constexpr unsigned green_shift = 8;
-		static constexpr unsigned blue_shift = 0;
-		static constexpr unsigned alpha_shift = 24;
-		static constexpr unsigned red_mask = 0xff << red_shift;
-		static constexpr unsigned green_mask = 0xff << green_shift;
-		static constexpr unsigned blue_mask = 0xff << blue_shift;
-		static constexpr unsigned alpha_mask = 0xff << alpha_shift;
-	public:
-		constexpr color() = default;
-		constexpr color(unsigned int rgb_or_argb, unsigned char a = 0) :
-			r{ static_cast<real>((rgb_or_argb & red_mask) >> red_shift) / 255.f },
-			g{ static_cast<real>((rgb_or_argb & green_mask) >> green_shift) / 255.f },
-			b{ static_cast<real>((rgb_or_argb & blue_mask) >> blue_shift) / 255.f }
-		{
-			if (a)
-				this->a = static_cast<real>(a / 255.f);
-			else
-				this->a = static_cast<real>((rgb_or_argb & alpha_mask) >> alpha_shift) / 255.f;
-		}
-		constexpr color(real r, real g, real b, real a = 1.f) :
-			r(r), g(g), b(b), a(a) {}
-		constexpr color(unsigned r, unsigned g, unsigned b, unsigned a = 255) :
-			r(static_cast<real>(r) / 255.f),
-			g(static_cast<real>(g) / 255.f),
-			b(static_cast<real>(b) / 255.f),
-			a(static_cast<real>(a) / 255.f) {}
-	public:
-		static constexpr color linear_interpolation(const color& c0, const color& c1, real ratio)
-		{
-			color ret;
-			ret.r = c0.r * (1 - ratio) + c1.r * ratio;
-			ret.g = c0.g * (1 - ratio) + c1.g * ratio;
-			ret.b = c0.b * (1 - ratio) + c1.b * ratio;
-			ret.a = c0.a * (1 - ratio) + c1.a * ratio;
-			return ret;
-		}
-
-#if _MSVC_LANG
-	public:
-		operator D2D1::ColorF() const
-		{
-			return D2D1::ColorF(r, g, b, a);
-		}
-#endif
-	};
+	class scene;
 
 	class logic_widget
 	{
 	public:
 		virtual ~logic_widget() {}
 		logic_widget() = default;
+		/// <summary>
+		/// 复制几何与状态，不复制树中的位置（自身、父节点）和待处理标记。
+		/// </summary>
 		logic_widget(const logic_widget& another) :
 			_x(another._x), _y(another._y), _cx(another._cx), _cy(another._cy),
-			_is_focused(another._is_focused), _is_activated(another._is_activated),
-			_is_visible(another._is_visible), _is_enabled(another._is_enabled),
+			_state((another._state & copied_states) | paint_dirty | subtree_dirty | layout_dirty | subtree_layout_dirty),
+			_layout(another._layout ? std::make_unique<layout_state>(*another._layout) : nullptr),
 			_ancestor(another._ancestor) {}
 		logic_widget& operator=(const logic_widget& another)
 		{
 			if (this != &another)
 			{
-				this->~logic_widget();
-				new(this) logic_widget(another);
+				_x = another._x;
+				_y = another._y;
+				_cx = another._cx;
+				_cy = another._cy;
+				_state = (_state & ~copied_states) | (another._state & copied_states);
+				_layout = another._layout ? std::make_unique<layout_state>(*another._layout) : nullptr;
+				_ancestor = another._ancestor;
+				invalidate();
+				invalidate_measure();
 			}
 			return *this;
 		}
@@ -203,15 +177,15 @@ namespace direct_ui
 		real _cx{};
 		real _cy{};
 	public:
-		const real& x{ _x };
-		const real& y{ _y };
-		const real& cx{ _cx };
-		const real& cy{ _cy };
+		real x() const { return _x; }
+		real y() const { return _y; }
+		real cx() const { return _cx; }
+		real cy() const { return _cy; }
 	public:
-		real left() const { return x; }
-		real top() const { return y; }
-		real right() const { return x + cx; }
-		real bottom() const { return y + cy; }
+		real left() const { return _x; }
+		real top() const { return _y; }
+		real right() const { return _x + _cx; }
+		real bottom() const { return _y + _cy; }
 	public:
 		void move(std::optional<real> x, std::optional<real> y)
 		{
@@ -219,62 +193,115 @@ namespace direct_ui
 				_x = *x;
 			if (y)
 				_y = *y;
+			invalidate_ancestors();
 		}
 		void resize(std::optional<real> cx, std::optional<real> cy)
 		{
+			real old_cx = _cx, old_cy = _cy;
 			on_resize(cx ? *cx : _cx, cy ? *cy : _cy);
 			if (cx)
 				_cx = *cx;
 			if (cy)
 				_cy = *cy;
+			invalidate();
+			if (_cx == old_cx && _cy == old_cy)
+				return;
+			// 布局中的控件以当前尺寸为自然尺寸，手动改变尺寸即改变了测量结果。
+			if (_layout)
+				invalidate_measure();
+			else
+			{
+				exchange_state(layout_dirty, true);
+				invalidate_layout_ancestors();
+			}
 		}
 	private:
-		bool _is_focused{};
-		bool _is_activated{};
-		bool _is_visible{ true };
-		bool _is_enabled{ true };
-	public:
-		bool is_focusable{ true };
+		/// <summary>
+		/// 状态位。绘制线程与更新线程都会读写，因此整体为原子量。
+		/// </summary>
+		enum state_bit : std::uint16_t
+		{
+			focused = 1 << 0,
+			activated = 1 << 1,
+			visible = 1 << 2,
+			enabled = 1 << 3,
+			focusable = 1 << 4,
+			update_pending = 1 << 5,
+			paint_dirty = 1 << 6,
+			subtree_dirty = 1 << 7,
+			independent_children = 1 << 8,
+			layout_dirty = 1 << 9, // 需要重新排列子控件。
+			subtree_layout_dirty = 1 << 10,
+			deferred_measure = 1 << 11, // 合并到下一次更新的测量失效。
+			low_priority = 1 << 12,
+		};
+		static constexpr std::uint16_t copied_states = focused | activated | visible | enabled | focusable | independent_children |
+			low_priority;
+		mutable std::atomic<std::uint16_t> _state{ visible | enabled | focusable | paint_dirty | subtree_dirty |
+			layout_dirty | subtree_layout_dirty };
+		bool test_state(state_bit bit) const
+		{
+			return _state.load() & bit;
+		}
+		/// <summary>
+		/// 设置状态位，返回原来的值。
+		/// </summary>
+		bool exchange_state(state_bit bit, bool value) const
+		{
+			return (value ? _state.fetch_or(bit) : _state.fetch_and(static_cast<std::uint16_t>(~bit))) & bit;
+		}
 	public:
-		const bool& is_foucsed{ _is_focused };
-		const bool& is_activated{ _is_activated };
-		const bool& is_visible{ _is_visible };
-		const bool& is_enabled{ _is_enabled };
+		bool is_focused() const { return test_state(focused); }
+		bool is_activated() const { return test_state(activated); }
+		bool is_visible() const { return test_state(visible); }
+		bool is_enabled() const { return test_state(enabled); }
+		bool is_focusable() const { return test_state(focusable); }
+		void set_focusable(bool value) { exchange_state(focusable, value); }
+		/// <summary>
+		/// 低优先级控件的更新在场景超出帧预算时可以被推迟。
+		/// </summary>
+		void set_low_priority(bool value) { exchange_state(low_priority, value); }
+		bool is_low_priority() const { return test_state(low_priority); }
 	public:
 		bool set_focus()
 		{
-			if (is_focusable)
+			if (is_focusable())
 			{
-				_is_focused = true;
+				exchange_state(focused, true);
+				invalidate();
 				return true;
 			}
 			return false;
 		}
 		void kill_focus()
 		{
-			_is_focused = false;
+			exchange_state(focused, false);
+			invalidate();
 		}
 		void activate()
 		{
-			_is_activated = true;
+			exchange_state(activated, true);
+			invalidate();
 			on_activate();
 		}
 		void deactivate()
 		{
-			_is_activated = false;
+			exchange_state(activated, false);
+			invalidate();
 			on_deactivate();
 		}
 		void set_visible(bool visible)
 		{
-			_is_visible = visible;
+			exchange_state(state_bit::visible, visible);
+			invalidate();
 		}
 		void enable()
 		{
-			_is_enabled = true;
+			exchange_state(enabled, true);
 		}
 		void disable()
 		{
-			_is_enabled = false;
+			exchange_state(enabled, false);
 		}
 
 	public:
@@ -292,24 +319,225 @@ namespace direct_ui
 		virtual void on_update(std::chrono::high_resolution_clock::duration elapsed) {}
 		virtual void on_activate() {}
 		virtual void on_deactivate() {}
+		/// <summary>
+		/// 内容需要的尺寸，不含外边距。默认为当前尺寸。结果按 available 缓存，内容变化后应调用 invalidate_measure。
+		/// </summary>
+		virtual layout_size on_measure(layout_size available) { return { _cx, _cy }; }
+		/// <summary>
+		/// 绘制时的整体不透明度。为零时所在的组跳过整个子树，不录制也不回放。默认不可见时为零。
+		/// 淡出的控件应重写为当前的透明度，以便在完全消失后才被剔除。
+		/// </summary>
+		virtual real paint_opacity() const { return is_visible() ? 1.f : 0.f; }
+
+	private:
+		/// <summary>
+		/// 布局参数与测量缓存。只有处在布局中的控件才分配。
+		/// </summary>
+		struct layout_state
+		{
+			layout_params params;
+			// 布局常先按不限尺寸、再按格子尺寸测量，保留最近两次结果。
+			struct entry
+			{
+				layout_size available{ -1, -1 };
+				layout_size measured;
+				bool valid{};
+			};
+			entry cache[2];
+			unsigned char next{};
+
+			void invalidate()
+			{
+				cache[0].valid = cache[1].valid = false;
+			}
+		};
+		std::unique_ptr<layout_state> _layout;
+		layout_state& layout_slot()
+		{
+			if (!_layout)
+				_layout = std::make_unique<layout_state>();
+			return *_layout;
+		}
+		layout_size measure(layout_size available)
+		{
+			auto& slot = layout_slot();
+			// 上次的结果没有受到可用空间的限制，而新的可用空间仍容得下它时，结果不变。
+			auto fits = [](layout_size m, layout_size a) { return m.cx <= a.cx && m.cy <= a.cy; };
+			auto unconstrained = [](layout_size m, layout_size a) { return m.cx < a.cx && m.cy < a.cy; };
+			for (const auto& e : slot.cache)
+				if (e.valid && e.available == available)
+					return e.measured;
+			for (const auto& e : slot.cache)
+				if (e.valid && unconstrained(e.measured, e.available) && fits(e.measured, available))
+					return e.measured;
+			const auto& p = slot.params;
+			layout_size ret;
+			if (p.cx && p.cy)
+				ret = { *p.cx, *p.cy };
+			else
+			{
+				ret = on_measure({ p.cx ? *p.cx : available.cx, p.cy ? *p.cy : available.cy });
+				if (p.cx)
+					ret.cx = *p.cx;
+				if (p.cy)
+					ret.cy = *p.cy;
+			}
+			slot.cache[slot.next] = { available, ret, true };
+			slot.next ^= 1;
+			return ret;
+		}
+		/// <summary>
+		/// 由布局放置。不改变测量结果，尺寸变化时只需重新排列自己的子控件。
+		/// </summary>
+		void set_bounds(const layout_rect& r)
+		{
+			if (_x != r.x || _y != r.y)
+			{
+				_x = r.x;
+				_y = r.y;
+				invalidate_ancestors();
+			}
+			if (_cx != r.cx || _cy != r.cy)
+			{
+				on_resize(r.cx, r.cy);
+				_cx = r.cx;
+				_cy = r.cy;
+				invalidate();
+				exchange_state(layout_dirty, true);
+			}
+		}
+		void invalidate_layout_ancestors()
+		{
+			for (auto p = _parent.lock(); p && !p->exchange_state(subtree_layout_dirty, true); p = p->_parent.lock())
+				;
+		}
+	public:
+		const layout_params& get_layout_params() const
+		{
+			static const layout_params none;
+			return _layout ? _layout->params : none;
+		}
+		void set_layout_params(const layout_params& params)
+		{
+			layout_slot().params = params;
+			invalidate_measure();
+		}
+		/// <summary>
+		/// 自然尺寸可能改变。使自己和尺寸随内容变化的祖先的测量缓存失效，并让所在的组重新排列。
+		/// </summary>
+		void invalidate_measure()
+		{
+			if (_layout)
+				_layout->invalidate();
+			exchange_state(layout_dirty, true);
+			auto p = _parent.lock();
+			if (!p)
+				return;
+			p->exchange_state(layout_dirty, true);
+			if (p->_layout && !(p->_layout->params.cx && p->_layout->params.cy))
+				p->invalidate_measure();
+			else
+				p->invalidate_layout_ancestors();
+		}
+		size_t layout_footprint() const
+		{
+			return _layout ? sizeof(layout_state) : 0;
+		}
+
+	public:
+		/// <summary>
+		/// 对象之外占用的堆内存（字节）。持有字符串、容器的控件应当重写并加上基类的结果。
+		/// </summary>
+		virtual size_t heap_footprint() const
+		{
+			return 0;
+		}
 
 		friend class scene;
 	private:
 		std::weak_ptr<scene> _ancestor;
+		std::weak_ptr<logic_widget> _self;
+		std::weak_ptr<logic_widget> _parent;
 	public:
-		const std::weak_ptr<scene>& ancestor{ _ancestor };
+		const std::weak_ptr<scene>& ancestor() const { return _ancestor; }
 		void require_update();
+		/// <summary>
+		/// 所在场景的动画引擎。不在场景中时为空。返回的指针同时使场景保持存活。
+		/// </summary>
+		std::shared_ptr<tween_engine> tweens() const;
+		void invalidate()
+		{
+			exchange_state(paint_dirty, true);
+			invalidate_ancestors();
+		}
+		void invalidate_ancestors()
+		{
+			for (auto p = _parent.lock(); p && !p->exchange_state(subtree_dirty, true); p = p->_parent.lock())
+				;
+		}
+		/// <summary>
+		/// 可观察属性变化后调用。不在场景中时不合并，立即失效。
+		/// </summary>
+		void invalidate_property(property_effect effects, bool batched)
+		{
+			if (effects & property_effect::paint)
+				invalidate();
+			if (effects & property_effect::measure)
+			{
+				if (!batched || ancestor().expired())
+					invalidate_measure();
+				else if (!exchange_state(deferred_measure, true))
+					require_update();
+			}
+			if (effects & property_effect::update)
+				require_update();
+		}
+		bool is_paint_dirty() const
+		{
+			return test_state(paint_dirty);
+		}
+
+		template <typename logic_t>
+		friend class dep_widget_interface;
+		template <typename logic_t>
+		friend class dep_widget;
+		friend class logic_group;
 	};
 	template <typename logic_t>
 	class dep_widget_interface
 	{
 	private:
 		virtual void init_resources() {}
+		mutable display_list commands;
 	public:
 		virtual ~dep_widget_interface() {}
 
 	public:
-		virtual void on_paint() const = 0;
+		virtual void on_paint(display_list& dl) const = 0;
+		virtual void on_compose(display_list& frame) const
+		{
+			compose_with(frame, *dynamic_cast<const logic_t*>(this), [this](display_list& dl) { on_paint(dl); });
+		}
+		/// <summary>
+		/// 与 on_compose 相同，但由调用者给出逻辑对象与绘制函数。已知控件的具体类型时，可以不经过虚函数直接调用其 on_paint。
+		/// </summary>
+		template <typename paint_t>
+		void compose_with(display_list& frame, const logic_widget& logic, paint_t&& paint) const
+		{
+			if (logic.exchange_state(logic_widget::paint_dirty, false))
+			{
+				commands.clear();
+				paint(commands);
+			}
+			frame.append(commands);
+		}
+		/// <summary>
+		/// 保留的显示列表占用的堆内存。
+		/// </summary>
+		size_t display_list_footprint() const
+		{
+			return commands.heap_footprint();
+		}
 
 		friend class scene;
 	};
@@ -317,10 +545,6 @@ namespace direct_ui
 	class dep_widget : virtual public dep_widget_interface<logic_t>
 	{
 	protected:
-#if _MSVC_LANG
-		ID2D1Factory* pFactory{};
-		ID2D1RenderTarget* pRenderTarget{};
-#endif
 		friend class scene;
 	};
 	using dep_widget_base = dep_widget<logic_widget>;
@@ -335,23 +559,139 @@ namespace direct_ui
 	{
 		return std::dynamic_pointer_cast<logic_t>(dep);
 	}
+	/// <summary>
+	/// 与 to_logic 相同，但返回不持有所有权的句柄，不产生引用计数操作。
+	/// </summary>
+	template <typename logic_t = logic_widget, typename dep_t>
+	inline widget_ref<logic_t> to_logic_ref(const std::shared_ptr<dep_t>& dep)
+		requires std::is_base_of_v<dep_widget_base, dep_t> || std::is_same_v<dep_widget_base, dep_t>
+	{
+		return dynamic_cast<logic_t*>(dep.get());
+	}
 
 	class logic_group : virtual public logic_widget
 	{
 	public:
 		std::vector<std::shared_ptr<dep_widget_base>> widgets;
+		/// <summary>
+		/// 将子树缓存到离屏层上。子树不变时，每帧只需按当前位置合成一次。
+		/// </summary>
+		bool cached_layer{};
+		/// <summary>
+		/// 声明各子控件的子树彼此独立。场景启用并行更新时，不同子树的 on_update 可以在不同线程上执行。
+		/// </summary>
+		void set_independent_children(bool value) { exchange_state(independent_children, value); }
+		bool has_independent_children() const { return test_state(independent_children); }
+
+	private:
+		std::shared_ptr<layout> _layout_engine;
+		size_t laid_out_children{};
+		/// <summary>
+		/// 把子控件交给布局访问。
+		/// </summary>
+		class children_context : public layout_context
+		{
+			logic_group& group;
+		public:
+			children_context(logic_group& group) : group(group) {}
+			virtual size_t count() const override
+			{
+				return group.widgets.size();
+			}
+			virtual const layout_params& params(size_t i) const override
+			{
+				return to_logic_ref(group.widgets[i])->get_layout_params();
+			}
+			virtual layout_size measure(size_t i, layout_size available) override
+			{
+				return to_logic_ref(group.widgets[i])->measure(available);
+			}
+			virtual void place(size_t i, const layout_rect& rect) override
+			{
+				to_logic_ref(group.widgets[i])->set_bounds(rect);
+			}
+		};
+	public:
+		/// <summary>
+		/// 设置布局。子控件的位置与尺寸此后由布局决定，参数见 set_layout_params。
+		/// 直接修改 widgets 后应调用 invalidate_layout。
+		/// </summary>
+		void set_layout(std::shared_ptr<layout> engine)
+		{
+			_layout_engine = std::move(engine);
+			invalidate_layout();
+		}
+		const std::shared_ptr<layout>& get_layout() const
+		{
+			return _layout_engine;
+		}
+		void invalidate_layout()
+		{
+			invalidate_measure();
+		}
+		/// <summary>
+		/// 只需重新排列子控件，自身的测量结果不变。
+		/// </summary>
+		void invalidate_arrange()
+		{
+			exchange_state(layout_dirty, true);
+			invalidate_layout_ancestors();
+		}
+		/// <summary>
+		/// 按当前尺寸排列子控件。
+		/// </summary>
+		void arrange()
+		{
+			on_arrange({ cx(), cy() });
+			laid_out_children = widgets.size();
+		}
+		virtual layout_size on_measure(layout_size available) override
+		{
+			if (!_layout_engine)
+				return logic_widget::on_measure(available);
+			children_context ctx(*this);
+			return _layout_engine->measure(ctx, available);
+		}
+
+		friend class scene;
+
+	protected:
+		/// <summary>
+		/// 排列子控件。派生的组可以在这里增减子控件，并用 place_child 放置。
+		/// </summary>
+		virtual void on_arrange(layout_size size)
+		{
+			if (!_layout_engine)
+				return;
+			children_context ctx(*this);
+			_layout_engine->arrange(ctx, size);
+		}
+		/// <summary>
+		/// 与布局相同地放置子控件。
+		/// </summary>
+		void place_child(logic_widget& child, const layout_rect& rect)
+		{
+			child._parent = _self;
+			child.set_bounds(rect);
+		}
 
 	public:
-		auto hittest(real x, real y) const
+		virtual size_t heap_footprint() const override
+		{
+			return widgets.capacity() * sizeof(widgets[0]);
+		}
+
+	public:
+		virtual std::shared_ptr<dep_widget_base> hittest(real x, real y) const
 		{
 			std::shared_ptr<dep_widget_base> ret;
 			for (const auto& widget : reversed(widgets))
 			{
-				auto logic = to_logic(widget);
-				if (logic->x <= x && x < logic->x + logic->cx &&
-					logic->y <= y && y < logic->y + logic->cy &&
-					logic->is_visible &&
-					logic->on_hittest(x - logic->x, y - logic->y))
+				auto logic = to_logic_ref(widget);
+				if (logic->x() <= x && x < logic->x() + logic->cx() &&
+					logic->y() <= y && y < logic->y() + logic->cy() &&
+					logic->is_visible() &&
+					logic->on_hittest(x - logic->x(), y - logic->y()))
 				{
 					ret = widget;
 					break;
@@ -378,17 +718,18 @@ namespace direct_ui
 				on_which = mouse_capture.first;
 			if (on_which)
 			{
-				auto logic = to_logic(on_which);
+				auto logic = to_logic_ref(on_which);
 				bool is_focus = logic->set_focus();
 				if (is_focus && focused && focused != on_which)
 				{
-					auto logic = to_logic(focused);
+					auto logic = to_logic_ref(focused);
 					logic->kill_focus();
 					focused.reset();
 				}
 				if (is_focus)
 					focused = on_which;
-				logic->on_left_down(x - logic->x, y - logic->y);
+				DIRECT_UI_TRACE_SCOPE("input", logic.get());
+				logic->on_left_down(x - logic->x(), y - logic->y());
 			}
 			mouse_capture.first = on_which;
 			mouse_capture.second++;
@@ -397,8 +738,9 @@ namespace direct_ui
 		{
 			if (mouse_capture.first)
 			{
-				auto logic = to_logic(mouse_capture.first);
-				logic->on_left_up(x - logic->x, y - logic->y);
+				auto logic = to_logic_ref(mouse_capture.first);
+				DIRECT_UI_TRACE_SCOPE("input", logic.get());
+				logic->on_left_up(x - logic->x(), y - logic->y());
 			}
 			if (!(--mouse_capture.second))
 				mouse_capture.first.reset();
@@ -410,17 +752,18 @@ namespace direct_ui
 				on_which = mouse_capture.first;
 			if (on_which)
 			{
-				auto logic = to_logic(on_which);
+				auto logic = to_logic_ref(on_which);
 				bool is_focus = logic->set_focus();
 				if (is_focus && focused && focused != on_which)
 				{
-					auto logic = to_logic(focused);
+					auto logic = to_logic_ref(focused);
 					logic->kill_focus();
 					focused.reset();
 				}
 				if (is_focus)
 					focused = on_which;
-				logic->on_mid_down(x - logic->x, y - logic->y);
+				DIRECT_UI_TRACE_SCOPE("input", logic.get());
+				logic->on_mid_down(x - logic->x(), y - logic->y());
 			}
 			mouse_capture.first = on_which;
 			mouse_capture.second++;
@@ -429,8 +772,9 @@ namespace direct_ui
 		{
 			if (mouse_capture.first)
 			{
-				auto logic = to_logic(mouse_capture.first);
-				logic->on_mid_up(x - logic->x, y - logic->y);
+				auto logic = to_logic_ref(mouse_capture.first);
+				DIRECT_UI_TRACE_SCOPE("input", logic.get());
+				logic->on_mid_up(x - logic->x(), y - logic->y());
 			}
 			if (!(--mouse_capture.second))
 				mouse_capture.first.reset();
@@ -442,17 +786,18 @@ namespace direct_ui
 				on_which = mouse_capture.first;
 			if (on_which)
 			{
-				auto logic = to_logic(on_which);
+				auto logic = to_logic_ref(on_which);
 				bool is_focus = logic->set_focus();
 				if (is_focus && focused && focused != on_which)
 				{
-					auto logic = to_logic(focused);
+					auto logic = to_logic_ref(focused);
 					logic->kill_focus();
 					focused.reset();
 				}
 				if (is_focus)
 					focused = on_which;
-				logic->on_right_down(x - logic->x, y - logic->y);
+				DIRECT_UI_TRACE_SCOPE("input", logic.get());
+				logic->on_right_down(x - logic->x(), y - logic->y());
 			}
 			mouse_capture.first = on_which;
 			mouse_capture.second++;
@@ -461,8 +806,9 @@ namespace direct_ui
 		{
 			if (mouse_capture.first)
 			{
-				auto logic = to_logic(mouse_capture.first);
-				logic->on_right_up(x - logic->x, y - logic->y);
+				auto logic = to_logic_ref(mouse_capture.first);
+				DIRECT_UI_TRACE_SCOPE("input", logic.get());
+				logic->on_right_up(x - logic->x(), y - logic->y());
 			}
 			if (!(--mouse_capture.second))
 				mouse_capture.first.reset();
@@ -479,19 +825,20 @@ namespace direct_ui
 				{
 					if (mouse_on)
 					{
-						auto logic = to_logic(mouse_on);
+						auto logic = to_logic_ref(mouse_on);
 						logic->on_mouse_leave();
 					}
 					mouse_on = on_which;
-					auto logic = to_logic(mouse_on);
+					auto logic = to_logic_ref(mouse_on);
 					logic->on_mouse_hover();
 				}
-				auto logic = to_logic(on_which);
-				logic->on_mouse_move(x - logic->x, y - logic->y);
+				auto logic = to_logic_ref(on_which);
+				DIRECT_UI_TRACE_SCOPE("input", logic.get());
+				logic->on_mouse_move(x - logic->x(), y - logic->y());
 			}
 			else if (mouse_on)
 			{
-				auto logic = to_logic(mouse_on);
+				auto logic = to_logic_ref(mouse_on);
 				logic->on_mouse_leave();
 				mouse_on.reset();
 			}
@@ -500,88 +847,240 @@ namespace direct_ui
 		{
 			if (mouse_on)
 			{
-				auto logic = to_logic(mouse_on);
+				auto logic = to_logic_ref(mouse_on);
 				logic->on_mouse_leave();
 				mouse_on.reset();
 			}
 		}
-		virtual void on_update(std::chrono::high_resolution_clock::duration elapsed) override
-		{
-			for (const auto& widget : widgets)
-				to_logic(widget)->on_update(elapsed);
-		}
 		virtual void on_activate() override
 		{
 			for (const auto& widget : widgets)
-				to_logic(widget)->activate();
+				to_logic_ref(widget)->activate();
 		}
 		virtual void on_deactivate() override
 		{
 			for (const auto& widget : widgets)
-				to_logic(widget)->deactivate();
+				to_logic_ref(widget)->deactivate();
 		}
 	};
-#if _MSVC_LANG
 	template <>
 	class dep_widget<logic_group> : virtual public logic_group, virtual public dep_widget_base
 	{
-	public:
-		virtual void on_paint() const override
+	private:
+		static unsigned next_layer_id()
 		{
-			pRenderTarget->PushAxisAlignedClip(D2D1::RectF(0, 0, cx, cy), D2D1_ANTIALIAS_MODE_ALIASED);
-			D2D1_MATRIX_3X2_F transform;
-			pRenderTarget->GetTransform(&transform);
+			static std::atomic<unsigned> counter{};
+			return ++counter;
+		}
+		const unsigned layer{ next_layer_id() };
+		mutable real layer_cx{};
+		mutable real layer_cy{};
+		mutable size_t layer_children{};
+		mutable unsigned layer_generation{};
+
+	protected:
+		virtual void compose_children(display_list& frame) const
+		{
+			exchange_state(subtree_dirty, false);
+			frame.push_clip(0, 0, cx(), cy());
 			for (const auto& widget : widgets)
 			{
-				auto logic = to_logic(widget);
-				auto move = D2D1::Matrix3x2F::Translation(logic->x, logic->y);
-				pRenderTarget->SetTransform(transform * move);
-				widget->on_paint();
+				auto logic = to_logic_ref(widget);
+				logic->_parent = _self;
+				// 完全透明或整个落在裁剪区域之外的子控件不参与合成。控件只在自身范围内绘制。
+				if (logic->paint_opacity() <= 0 ||
+					logic->x() >= cx() || logic->y() >= cy() ||
+					logic->x() + logic->cx() <= 0 || logic->y() + logic->cy() <= 0)
+				{
+					frame.composed.culled++;
+					continue;
+				}
+				frame.composed.painted++;
+				DIRECT_UI_TRACE_SCOPE("paint", widget.get());
+				frame.push_transform(matrix::translation(logic->x(), logic->y()));
+				widget->on_compose(frame);
+				frame.pop_transform();
 			}
-			pRenderTarget->SetTransform(transform);
-			pRenderTarget->PopAxisAlignedClip();
+			frame.pop_clip();
+		}
+	private:
+		bool is_layer_dirty() const;
+	public:
+		~dep_widget();
+	public:
+		virtual void on_paint(display_list& dl) const override {}
+		virtual void on_compose(display_list& frame) const override
+		{
+			if (!cached_layer)
+			{
+				compose_children(frame);
+				return;
+			}
+			if (is_layer_dirty())
+			{
+				frame.begin_layer(layer, cx(), cy());
+				compose_children(frame);
+				frame.end_layer();
+			}
+			frame.draw_layer(layer, cx(), cy());
 		}
 	};
 	using group = dep_widget<logic_group>;
 	static_assert(has_implimented_dep_widget<logic_group>);
-#endif
 
-#if _MSVC_LANG
+	class input_queue
+	{
+	public:
+		enum class event_type : unsigned char
+		{
+			mouse_move,
+			mouse_leave,
+			left_down,
+			left_up,
+			mid_down,
+			mid_up,
+			right_down,
+			right_up,
+		};
+		struct event
+		{
+			event_type type;
+			int x;
+			int y;
+		};
+	private:
+		// 启用渲染线程后，输入在界面线程上投递，在更新线程上分发。
+		mutable std::mutex mutex;
+		std::vector<event> events;
+		std::vector<event> flushing;
+		// 统计在更新线程上累加，在界面线程上读取。
+		std::atomic<size_t> _raw_count{};
+		std::atomic<size_t> _delivered_count{};
+	public:
+		void push(event_type type, int x = 0, int y = 0)
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			_raw_count.fetch_add(1, std::memory_order_relaxed);
+			if (type == event_type::mouse_move &&
+				!events.empty() && events.back().type == event_type::mouse_move)
+				events.back() = { type, x, y };
+			else
+				events.push_back({ type, x, y });
+		}
+		template <typename callback_t>
+		void flush(callback_t&& callback)
+			requires std::invocable<callback_t, const event&>
+		{
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				flushing.swap(events);
+			}
+			for (const auto& e : flushing)
+			{
+				_delivered_count.fetch_add(1, std::memory_order_relaxed);
+				callback(e);
+			}
+			flushing.clear();
+		}
+		bool empty() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			return events.empty();
+		}
+		size_t raw_count() const { return _raw_count.load(std::memory_order_relaxed); }
+		size_t delivered_count() const { return _delivered_count.load(std::memory_order_relaxed); }
+		void reset_counters()
+		{
+			_raw_count.store(0, std::memory_order_relaxed);
+			_delivered_count.store(0, std::memory_order_relaxed);
+		}
+	};
+
+	/// <summary>
+	/// 一种控件的内存占用汇总。
+	/// </summary>
+	struct widget_memory
+	{
+		size_t count{};
+		size_t object_bytes{}; // sizeof 之和。
+		size_t heap_bytes{}; // 堆内存之和，包括保留的显示列表。
+	};
+
 	class scene
 	{
 		std::weak_ptr<scene> self;
 	public:
-		ID2D1Factory* pFactory;
-		IDWriteFactory* pDWriteFactory;
-		ID2D1RenderTarget* pRenderTarget;
-		HWND hwnd;
+		std::unique_ptr<render_backend> backend;
+		std::function<void()> invalidate_callback{ [] {} };
 
+	private:
+		// 控件从池中分配，必须在 contents 之前构造。场景析构时放弃池，池在最后一个控件释放后销毁。
+		widget_pool::handle pool{ widget_pool::create() };
+		/// <summary>
+		/// 各控件类型的 sizeof，每种类型在第一次构建时登记。
+		/// </summary>
+		static lockfree<std::unordered_map<std::type_index, size_t>>& widget_sizes()
+		{
+			static lockfree<std::unordered_map<std::type_index, size_t>> ret;
+			return ret;
+		}
 	public:
 		std::shared_ptr<group> contents;
 
 	public:
-		scene(ID2D1Factory* pFactory, IDWriteFactory* pDWriteFactory, ID2D1RenderTarget* pRenderTarget, HWND hwnd) :
-			pFactory(pFactory),
-			pDWriteFactory(pDWriteFactory),
-			pRenderTarget(pRenderTarget),
-			hwnd(hwnd),
+		scene(std::unique_ptr<render_backend> backend) :
+			backend(std::move(backend)),
 			contents(build_dep_widget<group>())
 		{
-
+			_tweens->set_wake([this] { update(); });
 		}
 		~scene()
 		{
-			if (pRenderTarget)
-				pRenderTarget->Release();
+			// 控件可能比场景活得久，并继续持有动画引擎。
+			_tweens->set_wake({});
+			// 计时器线程与渲染线程会访问几乎所有成员，包括声明在它们之后的成员，
+			// 因此在任何成员析构之前先结束它们。渲染线程画完最后一帧时，调控器与后端仍然有效。
+			update_timer.stop();
+			pipeline.reset();
+			pipelined = false;
 		}
 
+	private:
+		mutable lockfree<std::vector<std::weak_ptr<logic_widget>>> pending_updates;
+		std::vector<std::weak_ptr<logic_widget>> dispatching;
+		tween_engine::handle _tweens{ tween_engine::create() };
+		std::unique_ptr<work_stealing_pool> update_pool;
+		std::vector<std::pair<const logic_widget*, std::shared_ptr<logic_widget>>> keyed_updates;
+		std::vector<std::pair<size_t, size_t>> update_batches;
+		// 计时器线程也会记录事件。替换记录器需要加锁，未记录时只读一个标志。
+		lockfree<std::shared_ptr<event_recorder>> recorder;
+		std::atomic<bool> recording{};
+		// 更新与绘制之前都会解析布局，两者可能在不同线程上。
+		std::mutex layout_mutex;
+		// 渲染线程与生成帧所需的状态，由计时器线程使用。
+		std::mutex frame_mutex;
+		std::unique_ptr<render_pipeline> pipeline;
+		std::atomic<bool> pipelined{};
+		lockfree<std::vector<std::function<void()>>> posted_tasks;
+		std::vector<std::function<void()>> running_tasks;
+		std::optional<render_snapshot::resize_request> pending_resize;
+		std::atomic<size_t> painted_count{};
+		std::atomic<size_t> culled_count{};
+		frame_governor _governor;
+		// 更新时钟：各次 on_update 的时长之和。低优先级控件进入待更新列表时记下当时的时钟，
+		// 分发时得到自请求以来经过的时间，而不是推迟开始以来的全部时间。
+		std::atomic<std::chrono::high_resolution_clock::rep> update_clock{};
+		lockfree<std::map<std::weak_ptr<logic_widget>, std::chrono::high_resolution_clock::rep, std::owner_less<>>> low_priority_since;
+		std::unordered_map<const logic_widget*, std::chrono::high_resolution_clock::duration> low_priority_elapsed;
+		unsigned low_priority_frames{};
 	private:
 		void timer_routine()
 		{
 			auto new_pre = std::chrono::high_resolution_clock::now();
-			bool into = update_flag;
-			update_flag = false;
-			if (into)
+			bool into = update_flag.exchange(false);
+			if (into && pipelined)
+				on_frame(new_pre - pre.load());
+			else if (into)
 				on_update();
 			if (!update_flag)
 				update_timer.kill();
@@ -589,17 +1088,71 @@ namespace direct_ui
 				pre = new_pre;
 		}
 		timer update_timer{ std::bind(&scene::timer_routine, this) };
-		bool update_flag{};
-		std::chrono::high_resolution_clock::time_point pre{};
+		// 并行更新时，控件会在工作线程上调用 require_update。
+		std::atomic<bool> update_flag{};
+		bool _manual_update{};
+		std::atomic<std::chrono::high_resolution_clock::time_point> pre{};
 	public:
 		void update()
 		{
-			if (!update_flag)
-			{
+			if (!update_flag.exchange(true))
 				pre = std::chrono::high_resolution_clock::now();
-				update_flag = true;
+			if (!_manual_update)
+				update_timer.set(tick_interval());
+		}
+		/// <summary>
+		/// 停用计时器，改由调用者以 on_update(elapsed) 推进。用于无窗口回放。
+		/// </summary>
+		void set_manual_update(bool manual)
+		{
+			_manual_update = manual;
+			if (manual)
+				update_timer.kill();
+			else if (update_flag)
+				update_timer.set(tick_interval());
+		}
+	private:
+		std::chrono::high_resolution_clock::duration tick_interval() const
+		{
+			return std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(_governor.tick_interval());
+		}
+	public:
+		/// <summary>
+		/// 帧预算调控器。以 set_policy 启用后，场景按其决定降低计时频率、推迟低优先级控件的更新，
+		/// 控件可以据此跳过装饰效果。
+		/// </summary>
+		frame_governor& governor()
+		{
+			return _governor;
+		}
+		const frame_governor& governor() const
+		{
+			return _governor;
+		}
+		void require_update(logic_widget& widget)
+		{
+			if (!widget.exchange_state(logic_widget::update_pending, true))
+			{
+				{
+					auto view = pending_updates.view();
+					view->push_back(widget._self);
+				}
+				if (widget.is_low_priority())
+				{
+					auto since = low_priority_since.view();
+					since->try_emplace(widget._self, update_clock.load());
+				}
 			}
-			update_timer.set(std::chrono::milliseconds(10));
+			update();
+		}
+		size_t pending_update_count() const
+		{
+			auto view = pending_updates.view();
+			return view->size();
+		}
+		tween_engine* tweens() const
+		{
+			return _tweens.get();
 		}
 	private:
 		real _cx{}, _cy{}, _scale{};
@@ -610,68 +1163,508 @@ namespace direct_ui
 	public:
 		void resize(int width, int height, int dpi)
 		{
-			_scale = static_cast<real>(dpi) / USER_DEFAULT_SCREEN_DPI;
+			record(event_log::event_type::resize, width, height, dpi);
+			if (pipelined)
+			{
+				post([this, width, height, dpi] { apply_resize(width, height, dpi); });
+				return;
+			}
+			apply_resize(width, height, dpi);
+		}
+	private:
+		void apply_resize(int width, int height, int dpi)
+		{
+			_scale = static_cast<real>(dpi) / render_backend::default_dpi;
 			_cx = width / scale;
 			_cy = height / scale;
-			reinterpret_cast<ID2D1HwndRenderTarget*>(pRenderTarget)->Resize(D2D1::SizeU(width, height));
-			pRenderTarget->SetDpi(dpi, dpi);
+			// 渲染线程运行时，后端只能在渲染线程上使用，尺寸随下一帧交过去。
+			if (pipelined)
+				pending_resize = { width, height, dpi };
+			else
+				backend->resize(width, height, dpi);
+			_layer_generation++;
 			to_logic(contents)->resize(cx, cy);
 		}
+	public:
+		/// <summary>
+		/// 测量文字尺寸，不绘制。结果与绘制共用后端的排版缓存。
+		/// </summary>
+		text_metrics measure_text(std::wstring_view str, const text_format& format,
+			real max_width, real max_height) const
+		{
+			// 布局以 unbounded 测量时，排版框与缓存键都使用有限的尺寸。
+			return backend->measure_text(str, format, layout_size::finite(max_width), layout_size::finite(max_height));
+		}
+		text_metrics measure_text(const std::u8string& str, const text_format& format,
+			real max_width, real max_height) const
+		{
+			return measure_text(code_conv<char8_t, wchar_t>::convert(str), format, max_width, max_height);
+		}
+
+	private:
+		void record(event_log::event_type type, std::int64_t a = 0, std::int64_t b = 0, std::int64_t c = 0)
+		{
+			if (!recording.load(std::memory_order_relaxed))
+				return;
+			std::shared_ptr<event_recorder> r;
+			{
+				auto view = recorder.view();
+				r = *view;
+			}
+			if (r)
+				r->record(type, a, b, c);
+		}
+	public:
+		/// <summary>
+		/// 开始记录进入场景的事件。先记录当前尺寸，回放时据此还原。传入空指针停止记录。
+		/// </summary>
+		void start_recording(std::shared_ptr<event_recorder> r)
+		{
+			if (r)
+				r->record(event_log::event_type::resize,
+					static_cast<std::int64_t>(cx * scale + 0.5f), static_cast<std::int64_t>(cy * scale + 0.5f),
+					static_cast<std::int64_t>(scale * render_backend::default_dpi + 0.5f));
+			recording = static_cast<bool>(r);
+			auto view = recorder.view();
+			*view = std::move(r);
+		}
+		void stop_recording()
+		{
+			start_recording({});
+		}
 
+	private:
+		display_list frame;
+		unsigned _layer_generation{};
+		lockfree<std::vector<unsigned>> released_layers;
 	public:
+		unsigned layer_generation() const
+		{
+			return _layer_generation;
+		}
+		void release_layer(unsigned layer)
+		{
+			auto view = released_layers.view();
+			view->push_back(layer);
+		}
+	public:
+		/// <summary>
+		/// 合成并绘制一帧。渲染线程运行时只请求更新线程生成新的一帧。
+		/// </summary>
 		void on_paint()
 		{
-			pRenderTarget->BeginDraw();
-			contents->on_paint();
-			pRenderTarget->EndDraw();
+			if (pipelined)
+			{
+				update();
+				return;
+			}
+			DIRECT_UI_TRACE_SCOPE("paint", "scene::on_paint");
+			resolve_layout();
+			compose(frame);
+			{
+				auto view = released_layers.view();
+				for (auto layer : *view)
+					backend->release_layer(layer);
+				view->clear();
+			}
+			{
+				DIRECT_UI_TRACE_SCOPE("paint", "replay");
+				frame_phase_timer timing(_governor, frame_governor::phase::render);
+				backend->begin_draw();
+				backend->replay(frame);
+				backend->end_draw();
+			}
+			_governor.end_frame();
+			record(event_log::event_type::paint);
+		}
+	private:
+		void resolve_layout(logic_widget& widget)
+		{
+			bool self = widget.exchange_state(logic_widget::layout_dirty, false);
+			bool subtree = widget.exchange_state(logic_widget::subtree_layout_dirty, false);
+			auto g = dynamic_cast<logic_group*>(&widget);
+			if (!g || !(self || subtree || g->laid_out_children != g->widgets.size()))
+				return;
+			for (const auto& child : g->widgets)
+				to_logic_ref(child)->_parent = g->_self;
+			if (self || g->laid_out_children != g->widgets.size())
+				g->arrange();
+			for (const auto& child : g->widgets)
+			{
+				auto logic = to_logic_ref(child);
+				if (logic->test_state(logic_widget::layout_dirty) || logic->test_state(logic_widget::subtree_layout_dirty))
+					resolve_layout(*logic);
+			}
+		}
+	public:
+		/// <summary>
+		/// 一次解析所有标记为脏的布局：只进入被标记的子树，测量结果未失效的控件不重新测量。
+		/// 在每次更新与绘制之前调用。
+		/// </summary>
+		void resolve_layout()
+		{
+			DIRECT_UI_TRACE_SCOPE("layout", "scene::resolve_layout");
+			frame_phase_timer timing(_governor, frame_governor::phase::layout);
+			std::lock_guard<std::mutex> lck(layout_mutex);
+			resolve_layout(*to_logic_ref(contents));
+		}
+	private:
+		void compose(display_list& dl)
+		{
+			DIRECT_UI_TRACE_SCOPE("paint", "compose");
+			frame_phase_timer timing(_governor, frame_governor::phase::compose);
+			dl.clear();
+			contents->on_compose(dl);
+			painted_count = dl.composed.painted;
+			culled_count = dl.composed.culled;
+		}
+		void render(render_snapshot& snapshot)
+		{
+			DIRECT_UI_TRACE_SCOPE("paint", "render");
+			{
+				frame_phase_timer timing(_governor, frame_governor::phase::render);
+				if (snapshot.resize)
+					backend->resize(snapshot.resize->width, snapshot.resize->height, snapshot.resize->dpi);
+				for (auto layer : snapshot.released_layers)
+					backend->release_layer(layer);
+				backend->begin_draw();
+				backend->replay(snapshot.frame);
+				backend->end_draw();
+			}
+			_governor.end_frame();
+		}
+		void run_posted_tasks()
+		{
+			{
+				auto view = posted_tasks.view();
+				running_tasks.swap(*view);
+			}
+			for (auto& task : running_tasks)
+				task();
+			running_tasks.clear();
+		}
+	public:
+		/// <summary>
+		/// 启动渲染线程。此后控件只在更新线程上访问：输入、尺寸与焦点变化都转交给更新线程，
+		/// 其他线程对控件的修改应通过 post 投递。更新线程每次推进后合成一帧快照交给渲染线程。
+		/// </summary>
+		void start_render_thread()
+		{
+			std::lock_guard<std::mutex> lck(frame_mutex);
+			if (pipeline)
+				return;
+			pipeline = std::make_unique<render_pipeline>([this](render_snapshot& snapshot) { render(snapshot); });
+			pipelined = true;
+			update();
+		}
+		/// <summary>
+		/// 渲染完已发布的帧后停止渲染线程，回到在界面线程上绘制。
+		/// </summary>
+		void stop_render_thread()
+		{
+			std::lock_guard<std::mutex> lck(frame_mutex);
+			if (!pipeline)
+				return;
+			pipeline.reset();
+			pipelined = false;
+			if (auto r = std::exchange(pending_resize, std::nullopt))
+				backend->resize(r->width, r->height, r->dpi);
+			run_posted_tasks();
+		}
+		bool is_render_thread_running() const
+		{
+			return pipelined;
+		}
+		/// <summary>
+		/// 在更新线程上、下一帧生成之前执行 task。渲染线程未运行时立即执行。
+		/// </summary>
+		void post(std::function<void()> task)
+		{
+			if (!pipelined)
+			{
+				task();
+				return;
+			}
+			{
+				auto view = posted_tasks.view();
+				view->push_back(std::move(task));
+			}
+			update();
+		}
+		/// <summary>
+		/// 在更新线程上生成一帧：执行投递的任务，分发输入，推进 elapsed，合成快照并交给渲染线程。
+		/// 计时器在渲染线程运行时调用它；手动推进时由调用者调用。渲染线程未运行时只推进。
+		/// </summary>
+		void on_frame(std::chrono::high_resolution_clock::duration elapsed)
+		{
+			std::lock_guard<std::mutex> lck(frame_mutex);
+			if (!pipeline)
+			{
+				on_update(elapsed);
+				return;
+			}
+			run_posted_tasks();
+			flush_input();
+			on_update(elapsed);
+			resolve_layout();
+			auto& snapshot = pipeline->back();
+			snapshot.clear();
+			compose(snapshot.frame);
+			snapshot.resize = std::exchange(pending_resize, std::nullopt);
+			{
+				auto view = released_layers.view();
+				snapshot.released_layers.swap(*view);
+			}
+			record(event_log::event_type::paint);
+			pipeline->publish();
+		}
+		/// <summary>
+		/// 等待渲染线程画完已发布的帧。
+		/// </summary>
+		void wait_rendered()
+		{
+			std::lock_guard<std::mutex> lck(frame_mutex);
+			if (pipeline)
+				pipeline->wait_idle();
 		}
 		void on_mouse_move(int x, int y)
 		{
+			record(event_log::event_type::mouse_move, x, y);
 			contents->on_mouse_move(x / scale, y / scale);
 		}
 		void on_mouse_leave()
 		{
+			record(event_log::event_type::mouse_leave);
 			contents->on_mouse_leave();
 		}
 		void on_left_down(int x, int y)
 		{
+			record(event_log::event_type::left_down, x, y);
 			contents->on_left_down(x / scale, y / scale);
 		}
 		void on_left_up(int x, int y)
 		{
+			record(event_log::event_type::left_up, x, y);
 			contents->on_left_up(x / scale, y / scale);
 		}
 		void on_mid_down(int x, int y)
 		{
+			record(event_log::event_type::mid_down, x, y);
 			contents->on_mid_down(x / scale, y / scale);
 		}
 		void on_mid_up(int x, int y)
 		{
+			record(event_log::event_type::mid_up, x, y);
 			contents->on_mid_up(x / scale, y / scale);
 		}
 		void on_right_down(int x, int y)
 		{
+			record(event_log::event_type::right_down, x, y);
 			contents->on_right_down(x / scale, y / scale);
 		}
 		void on_right_up(int x, int y)
 		{
+			record(event_log::event_type::right_up, x, y);
 			contents->on_right_up(x / scale, y / scale);
 		}
+	public:
+		input_queue input;
+		void post_input(input_queue::event_type type, int x = 0, int y = 0)
+		{
+			input.push(type, x, y);
+		}
+		/// <summary>
+		/// 分发排队的输入。渲染线程运行时输入在更新线程上分发，这里只请求生成新的一帧。
+		/// </summary>
+		void dispatch_input()
+		{
+			if (pipelined)
+			{
+				update();
+				return;
+			}
+			flush_input();
+		}
+	private:
+		void flush_input()
+		{
+			input.flush([this](const input_queue::event& e)
+				{
+					using enum input_queue::event_type;
+					switch (e.type)
+					{
+					case mouse_move:
+						on_mouse_move(e.x, e.y);
+						break;
+					case mouse_leave:
+						on_mouse_leave();
+						break;
+					case left_down:
+						on_left_down(e.x, e.y);
+						break;
+					case left_up:
+						on_left_up(e.x, e.y);
+						break;
+					case mid_down:
+						on_mid_down(e.x, e.y);
+						break;
+					case mid_up:
+						on_mid_up(e.x, e.y);
+						break;
+					case right_down:
+						on_right_down(e.x, e.y);
+						break;
+					case right_up:
+						on_right_up(e.x, e.y);
+						break;
+					}
+				});
+		}
+	public:
 		void on_update()
 		{
-			auto now = std::chrono::high_resolution_clock::now();
-			auto elapsed = now - pre;
-			contents->on_update(elapsed);
-			if (hwnd)
-				InvalidateRect(hwnd, nullptr, FALSE);
+			on_update(std::chrono::high_resolution_clock::now() - pre.load());
+		}
+		/// <summary>
+		/// 以给定的时长推进一次。
+		/// </summary>
+		void on_update(std::chrono::high_resolution_clock::duration elapsed)
+		{
+			DIRECT_UI_TRACE_SCOPE("update", "scene::on_update");
+			record(event_log::event_type::update,
+				std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+			resolve_layout();
+			frame_phase_timer timing(_governor, frame_governor::phase::update);
+			{
+				auto view = pending_updates.view();
+				dispatching.swap(*view);
+			}
+			// 合并的测量失效会改动祖先的缓存，在分发之前于本线程执行。
+			for (const auto& p : dispatching)
+				if (auto widget = p.lock(); widget && widget->exchange_state(logic_widget::deferred_measure, false))
+					widget->invalidate_measure();
+			// 超出预算时，低优先级控件放回待更新列表，每 low_priority_period 帧才更新一次，届时得到自请求以来的时间。
+			auto clock = update_clock += elapsed.count();
+			bool defer_low_priority = _governor.is_active(frame_degradation::defer_low_priority) &&
+				++low_priority_frames % _governor.low_priority_period();
+			if (defer_low_priority)
+			{
+				{
+					auto view = pending_updates.view();
+					std::erase_if(dispatching, [&](const std::weak_ptr<logic_widget>& p)
+						{
+							auto widget = p.lock();
+							if (!widget || !widget->is_low_priority())
+								return false;
+							view->push_back(p);
+							_governor.count_deferred_update();
+							return true;
+						});
+				}
+				update();
+			}
+			{
+				auto since = low_priority_since.view();
+				if (!since->empty())
+					for (const auto& p : dispatching)
+						if (auto it = since->find(p); it != since->end())
+						{
+							if (auto widget = p.lock())
+								low_priority_elapsed[widget.get()] = std::chrono::high_resolution_clock::duration(clock - it->second);
+							since->erase(it);
+						}
+			}
+			if (update_pool && dispatching.size() > 1)
+				dispatch_parallel(elapsed);
+			else
+				for (const auto& p : dispatching)
+					if (auto widget = p.lock())
+						dispatch_update(*widget, elapsed);
+			dispatching.clear();
+			low_priority_elapsed.clear();
+			auto dt = std::chrono::duration_cast<std::chrono::duration<real>>(elapsed).count();
+			DIRECT_UI_TRACE_SCOPE("update", "tween_engine::advance");
+			if (_tweens->advance(dt, [](logic_widget* widget)
+				{
+					if (widget)
+						widget->invalidate();
+				}))
+				update();
+			// 渲染线程运行时由它直接呈现，不需要窗口重绘。
+			if (!pipelined)
+				invalidate_callback();
+		}
+	private:
+		void dispatch_update(logic_widget& widget, std::chrono::high_resolution_clock::duration elapsed)
+		{
+			DIRECT_UI_TRACE_SCOPE("update", &widget);
+			widget.exchange_state(logic_widget::update_pending, false);
+			if (widget.is_low_priority())
+				if (auto it = low_priority_elapsed.find(&widget); it != low_priority_elapsed.end())
+					elapsed = it->second;
+			widget.on_update(elapsed);
+			widget.invalidate();
+		}
+		/// <summary>
+		/// 控件所属的独立子树，即最外层声明了独立子控件的组中，包含该控件的那个子控件。不属于任何独立子树时为空。
+		/// </summary>
+		static const logic_widget* independent_subtree(const logic_widget& widget)
+		{
+			const logic_widget* ret{};
+			const logic_widget* child = &widget;
+			for (auto p = widget._parent.lock(); p; p = p->_parent.lock())
+			{
+				if (p->test_state(logic_widget::independent_children))
+					ret = child;
+				child = p.get();
+			}
+			return ret;
+		}
+		/// <summary>
+		/// 按独立子树分批，不属于独立子树的控件先在本线程更新，各批再交给线程池，全部完成后返回。
+		/// </summary>
+		void dispatch_parallel(std::chrono::high_resolution_clock::duration elapsed)
+		{
+			for (const auto& p : dispatching)
+				if (auto widget = p.lock())
+					keyed_updates.emplace_back(independent_subtree(*widget), std::move(widget));
+			std::stable_sort(keyed_updates.begin(), keyed_updates.end(),
+				[](const auto& a, const auto& b) { return std::less<>()(a.first, b.first); });
+			size_t begin = 0;
+			for (; begin < keyed_updates.size() && !keyed_updates[begin].first; begin++)
+				dispatch_update(*keyed_updates[begin].second, elapsed);
+			for (size_t i = begin + 1; i <= keyed_updates.size(); i++)
+				if (i == keyed_updates.size() || keyed_updates[i].first != keyed_updates[i - 1].first)
+				{
+					update_batches.emplace_back(begin, i);
+					begin = i;
+				}
+			update_pool->run(update_batches.size(), [&](size_t batch)
+				{
+					for (auto i = update_batches[batch].first; i < update_batches[batch].second; i++)
+						dispatch_update(*keyed_updates[i].second, elapsed);
+				});
+			update_batches.clear();
+			keyed_updates.clear();
+		}
+	public:
+		/// <summary>
+		/// 启用并行更新，threads 为参与更新的线程数（含计时器线程），0 表示关闭。
+		/// 只有声明了独立子控件的组下的控件会被并行更新。应在场景开始更新之前调用。
+		/// </summary>
+		void set_parallel_update(size_t threads = std::thread::hardware_concurrency())
+		{
+			update_pool = threads > 1 ? std::make_unique<work_stealing_pool>(threads) : nullptr;
 		}
 		void on_set_focus()
 		{
-			contents->activate();
+			record(event_log::event_type::set_focus);
+			post([this] { contents->activate(); });
 		}
 		void on_kill_focus()
 		{
-			contents->deactivate();
+			record(event_log::event_type::kill_focus);
+			post([this] { contents->deactivate(); });
 		}
 	public:
 		template <typename dep_widget_t>
@@ -679,24 +1672,73 @@ namespace direct_ui
 			requires std::is_base_of_v<dep_widget_base, dep_widget_t>
 		{
 			using decayed = std::decay_t<dep_widget_t>;
-			auto ret = std::make_shared<decayed>();
+			[[maybe_unused]] static const bool registered = []
+			{
+				auto view = widget_sizes().view();
+				view->try_emplace(typeid(decayed), sizeof(decayed));
+				return true;
+			}();
+			auto ret = std::allocate_shared<decayed>(pool_allocator<decayed>(pool.get()));
 			ret->_ancestor = self;
-			ret->pFactory = pFactory;
-			ret->pRenderTarget = pRenderTarget;
+			ret->_self = ret;
 			ret->init_resources();
 			return ret;
 		}
 
+	public:
+		/// <summary>
+		/// 控件池的分配计数。
+		/// </summary>
+		pool_statistics widget_pool_statistics() const
+		{
+			return pool->statistics();
+		}
+		/// <summary>
+		/// 最近一帧合成时绘制与剔除的控件数。被剔除子树内的控件不计入。
+		/// </summary>
+		display_list::compose_statistics compose_statistics() const
+		{
+			return { painted_count.load(), culled_count.load() };
+		}
+		/// <summary>
+		/// 按控件类型统计 contents 下所有控件的内存占用，键为类型名。
+		/// </summary>
+		std::map<std::string, widget_memory> memory_report() const
+		{
+			std::map<std::string, widget_memory> ret;
+			auto view = widget_sizes().view();
+			auto visit = [&](auto&& visit, const std::shared_ptr<dep_widget_base>& widget) -> void
+			{
+				const auto& type = typeid(*widget);
+				auto& m = ret[type.name()];
+				m.count++;
+				if (auto it = view->find(type); it != view->end())
+					m.object_bytes += it->second;
+				auto logic = to_logic_ref(widget);
+				m.heap_bytes += logic->heap_footprint() + logic->layout_footprint() + widget->display_list_footprint();
+				if (auto g = to_logic_ref<logic_group>(widget))
+					for (const auto& child : g->widgets)
+						visit(visit, child);
+			};
+			visit(visit, contents);
+			return ret;
+		}
+
 		friend class scene_factory;
 	};
 	class scene_factory
 	{
+#if _MSVC_LANG
 		ID2D1Factory* pFactory;
 		IDWriteFactory* pDWriteFactory;
+		std::shared_ptr<d2d_text_format_cache> text_formats{ std::make_shared<d2d_text_format_cache>(64) };
+		std::shared_ptr<d2d_text_layout_cache> text_layouts{ std::make_shared<d2d_text_layout_cache>(1024, 1 << 20) };
+#endif
 
 	public:
 		scene_factory()
 		{
+#if _MSVC_LANG
 			if (FAILED(D2D1CreateFactory(
 				D2D1_FACTORY_TYPE::D2D1_FACTORY_TYPE_MULTI_THREADED, &pFactory)))
 				throw std::runtime_error("Fail to D2D1CreateFactory.");
@@ -705,6 +1747,7 @@ namespace direct_ui
 				__uuidof(IDWriteFactory),
 				reinterpret_cast<IUnknown**>(&pDWriteFactory))))
 				throw std::runtime_error("Fail to DWriteCreateFactory.");
+#endif
 		}
 		scene_factory(const scene_factory&) = delete;
 		scene_factory(scene_factory&&) = delete;
@@ -712,13 +1755,34 @@ namespace direct_ui
 		scene_factory& operator=(scene_factory&&) = delete;
 		~scene_factory()
 		{
+#if _MSVC_LANG
+			text_layouts->clear();
+			text_formats->clear();
 			if (pFactory)
 				pFactory->Release();
 			if (pDWriteFactory)
 				pDWriteFactory->Release();
+#endif
 		}
 
 	public:
+		std::shared_ptr<scene> build_scene(std::unique_ptr<render_backend> backend)
+		{
+			auto ret = std::make_shared<scene>(std::move(backend));
+			ret->self = ret;
+			return ret;
+		}
+		/// <summary>
+		/// 构造渲染到内存的无窗口场景。
+		/// </summary>
+		std::shared_ptr<scene> build_soft_scene(int width, int height, int dpi = render_backend::default_dpi,
+			std::shared_ptr<glyph_source> glyphs = std::make_shared<box_glyph_source>())
+		{
+			auto ret = build_scene(std::make_unique<soft_backend>(std::move(glyphs)));
+			ret->resize(width, height, dpi);
+			return ret;
+		}
+#if _MSVC_LANG
 		std::shared_ptr<scene> build_hwnd_scene(HWND hwnd)
 		{
 			ID2D1HwndRenderTarget* pRenderTarget;
@@ -727,17 +1791,46 @@ namespace direct_ui
 				&pRenderTarget)))
 				throw std::runtime_error("Fail to CreateHwndRenderTarget.");
 			pRenderTarget->SetDpi(USER_DEFAULT_SCREEN_DPI, USER_DEFAULT_SCREEN_DPI);
-			auto ret = std::make_shared<scene>(pFactory, pDWriteFactory, pRenderTarget, hwnd);
-			ret->self = ret;
+			auto ret = build_scene(std::make_unique<d2d_backend>(pDWriteFactory, pRenderTarget, text_formats, text_layouts));
+			ret->invalidate_callback = [hwnd] { InvalidateRect(hwnd, nullptr, FALSE); };
 			return ret;
 		}
+#endif
 	};
 	inline void direct_ui::logic_widget::require_update()
 	{
-		if (!ancestor.expired())
-			ancestor.lock()->update();
+		invalidate();
+		if (auto s = ancestor().lock())
+			s->require_update(*this);
+	}
+	inline std::shared_ptr<tween_engine> logic_widget::tweens() const
+	{
+		if (auto s = ancestor().lock())
+			return std::shared_ptr<tween_engine>(s, s->tweens());
+		return {};
+	}
+	inline bool dep_widget<logic_group>::is_layer_dirty() const
+	{
+		unsigned generation{};
+		if (auto s = ancestor().lock())
+			generation = s->layer_generation();
+		bool dirty = exchange_state(subtree_dirty, false);
+		dirty |= exchange_state(paint_dirty, false);
+		dirty |= layer_cx != cx() || layer_cy != cy() || layer_generation != generation;
+		dirty |= layer_children != widgets.size();
+		for (const auto& widget : widgets)
+			dirty |= to_logic_ref(widget)->_parent.lock().get() != static_cast<const logic_widget*>(this);
+		layer_cx = cx();
+		layer_cy = cy();
+		layer_generation = generation;
+		layer_children = widgets.size();
+		return dirty;
+	}
+	inline dep_widget<logic_group>::~dep_widget()
+	{
+		if (auto s = ancestor().lock())
+			s->release_layer(layer);
 	}
-#endif
 
 	class logic_button : virtual public logic_widget
 	{
@@ -746,31 +1839,24 @@ namespace direct_ui
 		int is_mouse_down{};
 	public:
 		std::function<void()> callback{ [] {} };
-		std::u8string caption;
+		DIRECT_UI_PROPERTY(logic_button, std::u8string, caption, property_effect::paint);
 	protected:
-		mutable double frame{};
+		tween frame{ 0, 10 };
 		static constexpr real max_radius = 233;
 		mutable lockfree<std::deque<std::tuple<real, real, real>>> circles;
+	public:
+		virtual size_t heap_footprint() const override
+		{
+			auto view = circles.view();
+			return direct_ui::heap_footprint(caption.get()) + view->size() * sizeof(std::tuple<real, real, real>);
+		}
 	public:
 		virtual void on_update(std::chrono::high_resolution_clock::duration interval) override
 		{
 			using namespace std::chrono;
 			auto sec = duration_cast<duration<double>>(interval).count();
 
-			{
-				double target_frame = 0;
-				if (is_mouse_hover && !is_mouse_down)
-					target_frame = 100;
-				constexpr double speed = 1000;
-				double step = speed * sec;
-				frame += (target_frame > frame ? step : -step);
-				if (!(0 <= frame))
-					frame = 0;
-				if (!(frame <= 100))
-					frame = 100;
-				if (std::abs(frame - target_frame) > 1e-6)
-					require_update();
-			}
+			frame.animate_to(*this, is_mouse_hover && !is_mouse_down ? 1.f : 0.f);
 			{
 				auto view = circles.view();
 				constexpr real speed = 400;
@@ -801,6 +1887,10 @@ namespace direct_ui
 		virtual void on_left_down(real x, real y) override
 		{
 			is_mouse_down++;
+			auto s = ancestor().lock();
+			if (s && s->governor().is_active(frame_degradation::skip_effects))
+				s->governor().count_skipped_effect();
+			else
 			{
 				auto view = circles.view();
 				view->push_back({ x, y, 0 });
@@ -815,124 +1905,67 @@ namespace direct_ui
 				callback();
 		}
 	};
-#if _MSVC_LANG
 	template <>
 	class dep_widget<logic_button> : virtual public logic_button, virtual public dep_widget_base
 	{
-		ID2D1SolidColorBrush* brush{};
-		ID2D1SolidColorBrush* brush_frame{};
-		ID2D1SolidColorBrush* brush_font{};
-		IDWriteTextFormat* text_format{};
+		mutable converted_text caption_text;
 
 	public:
-		virtual void on_paint() const override
+		virtual size_t heap_footprint() const override
 		{
-			pRenderTarget->FillRectangle(D2D1::RectF(0, 0, cx, cy), brush);
+			return logic_button::heap_footprint() + caption_text.heap_footprint();
+		}
+
+	public:
+		virtual void on_paint(display_list& dl) const override
+		{
+			dl.fill_rect(0, 0, cx(), cy(), color(0xCCCCCC, 255));
 			{
-				pRenderTarget->PushAxisAlignedClip(D2D1::RectF(0, 0, cx, cy),
-					D2D1_ANTIALIAS_MODE::D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+				dl.push_clip(0, 0, cx(), cy());
+				// 所有波纹合并为一条批量命令。
 				auto view = circles.view();
 				for (const auto& c : *view)
 				{
 					const auto& [x, y, r] = c;
 
-					ID2D1SolidColorBrush* circle_brush{};
 					real value = 0x7A + (0xCC - 0x7A) * (r / max_radius);
 					value /= 255;
-					auto color = D2D1::ColorF(value, value, value, 0.5);
-					pRenderTarget->CreateSolidColorBrush(color, &circle_brush);
-					pRenderTarget->FillEllipse(D2D1::Ellipse(D2D1::Point2F(x, y), r, r), circle_brush);
-					circle_brush->Release();
+					dl.fill_circle(x, y, r, color(value, value, value, 0.5f));
 				}
-				pRenderTarget->PopAxisAlignedClip();
-			}
-			if (frame)
-			{
-				auto properties = D2D1::StrokeStyleProperties();
-				pRenderTarget->DrawRectangle(D2D1::RectF(0, 0, cx, cy), brush_frame, 2.0f * frame / 100);
+				dl.pop_clip();
 			}
-			{
-				auto str = code_conv<char8_t, wchar_t>::convert(caption);
-				pRenderTarget->DrawTextW(str.c_str(),
-					str.length(), text_format,
-					D2D1::RectF(0, 0, cx, cy),
-					brush_font);
-			}
-		}
-
-	private:
-		virtual void init_resources() override
-		{
-			pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0xCCCCCC), &brush);
-			pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0x7A7A7A), &brush_frame);
-			pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0x000000), &brush_font);
-			IDWriteFactory* dwFactory = ancestor.lock()->pDWriteFactory;
-			dwFactory->CreateTextFormat(
-				L"Segoe UI",                // Font family name.
-				nullptr,                       // Font collection (NULL sets it to use the system font collection).
-				DWRITE_FONT_WEIGHT_REGULAR,
-				DWRITE_FONT_STYLE_NORMAL,
-				DWRITE_FONT_STRETCH_NORMAL,
-				14.0f,
-				L"",
-				&text_format);
-			text_format->SetTextAlignment(DWRITE_TEXT_ALIGNMENT::DWRITE_TEXT_ALIGNMENT_CENTER);
-			text_format->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
-		}
-	public:
-		~dep_widget()
-		{
-			if (brush)
-				brush->Release();
-			if (brush_frame)
-				brush_frame->Release();
-			if (brush_font)
-				brush_font->Release();
-			if (text_format)
-				text_format->Release();
+			if (auto f = frame.value())
+				dl.draw_rect(0, 0, cx(), cy(), color(0x7A7A7A, 255), 2 * f);
+			dl.draw_text(caption_text(caption), {}, 0, 0, cx(), cy(), color(0x000000, 255));
 		}
 
 		friend class scene;
 	};
 	using button = dep_widget<logic_button>;
 	static_assert(has_implimented_dep_widget<logic_button>);
-#endif
 
 	class logic_rect : virtual public logic_widget
 	{
 	public:
-		color brush_color{};
-		color pen_color{};
-		real pen_size{};
+		DIRECT_UI_PROPERTY(logic_rect, color, brush_color, property_effect::paint);
+		DIRECT_UI_PROPERTY(logic_rect, color, pen_color, property_effect::paint);
+		DIRECT_UI_PROPERTY(logic_rect, real, pen_size, property_effect::paint);
 		logic_rect()
 		{
-			is_focusable = false;
+			set_focusable(false);
 		}
 	};
-#if _MSVC_LANG
 	template <>
 	class dep_widget<logic_rect> : virtual public logic_rect, virtual public dep_widget_base
 	{
 	public:
-		virtual void on_paint() const override
+		virtual void on_paint(display_list& dl) const override
 		{
-			auto rect = D2D1::RectF(0, 0, cx, cy);
-			{
-				ID2D1SolidColorBrush* brush;
-				pRenderTarget->CreateSolidColorBrush(brush_color, &brush);
-				pRenderTarget->FillRectangle(rect, brush);
-				brush->Release();
-			}
+			dl.fill_rect(0, 0, cx(), cy(), brush_color);
 			if (pen_size)
-			{
-				ID2D1SolidColorBrush* brush;
-				pRenderTarget->CreateSolidColorBrush(pen_color, &brush);
-				pRenderTarget->DrawRectangle(rect, brush, pen_size);
-				brush->Release();
-			}
+				dl.draw_rect(0, 0, cx(), cy(), pen_color, pen_size);
 		}
 	};
 	using rect = dep_widget<logic_rect>;
 	static_assert(has_implimented_dep_widget<logic_rect>);
-#endif
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+﻿#pragma once
+
+// 软件光栅化与动画推进中的 SIMD 路径。
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DIRECT_UI_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if _MSVC_LANG
+#include <Windows.h>
+#undef min
+#undef max
+#include <d2d1.h>
+#endif
+
+namespace direct_ui
+{
+	using real = float;
+	class color
+	{
+	public:
+		real r{};
+		real g{};
+		real b{};
+		real a{ 1 };
+	public:
+		static constexpr unsigned red_shift = 16;
+		static constexpr unsigned green_shift = 8;
+		static constexpr unsigned blue_shift = 0;
+		static constexpr unsigned alpha_shift = 24;
+		static constexpr unsigned red_mask = 0xff << red_shift;
+		static constexpr unsigned green_mask = 0xff << green_shift;
+		static constexpr unsigned blue_mask = 0xff << blue_shift;
+		static constexpr unsigned alpha_mask = 0xff << alpha_shift;
+	public:
+		constexpr color() = default;
+		constexpr color(unsigned int rgb_or_argb, unsigned char a = 0) :
+			r{ static_cast<real>((rgb_or_argb & red_mask) >> red_shift) / 255.f },
+			g{ static_cast<real>((rgb_or_argb & green_mask) >> green_shift) / 255.f },
+			b{ static_cast<real>((rgb_or_argb & blue_mask) >> blue_shift) / 255.f }
+		{
+			if (a)
+				this->a = static_cast<real>(a / 255.f);
+			else
+				this->a = static_cast<real>((rgb_or_argb & alpha_mask) >> alpha_shift) / 255.f;
+		}
+		constexpr color(real r, real g, real b, real a = 1.f) :
+			r(r), g(g), b(b), a(a) {}
+		constexpr color(unsigned r, unsigned g, unsigned b, unsigned a = 255) :
+			r(static_cast<real>(r) / 255.f),
+			g(static_cast<real>(g) / 255.f),
+			b(static_cast<real>(b) / 255.f),
+			a(static_cast<real>(a) / 255.f) {}
+	public:
+		static constexpr color linear_interpolation(const color& c0, const color& c1, real ratio)
+		{
+			color ret;
+			ret.r = c0.r * (1 - ratio) + c1.r * ratio;
+			ret.g = c0.g * (1 - ratio) + c1.g * ratio;
+			ret.b = c0.b * (1 - ratio) + c1.b * ratio;
+			ret.a = c0.a * (1 - ratio) + c1.a * ratio;
+			return ret;
+		}
+
+#if _MSVC_LANG
+	public:
+		operator D2D1::ColorF() const
+		{
+			return D2D1::ColorF(r, g, b, a);
+		}
+#endif
+	};
+
+	/// <summary>
+	/// 3x2 仿射变换矩阵。与 Direct2D 一致，点以行向量右乘矩阵。
+	/// </summary>
+	class matrix
+	{
+	public:
+		real m11{ 1 };
+		real m12{};
+		real m21{};
+		real m22{ 1 };
+		real dx{};
+		real dy{};
+	public:
+		constexpr matrix() = default;
+		constexpr matrix(real m11, real m12, real m21, real m22, real dx, real dy) :
+			m11(m11), m12(m12), m21(m21), m22(m22), dx(dx), dy(dy) {}
+	public:
+		static constexpr matrix identity()
+		{
+			return {};
+		}
+		static constexpr matrix translation(real x, real y)
+		{
+			return { 1, 0, 0, 1, x, y };
+		}
+		static constexpr matrix scale(real sx, real sy)
+		{
+			return { sx, 0, 0, sy, 0, 0 };
+		}
+	public:
+		/// <summary>
+		/// 先应用 this，再应用 another。
+		/// </summary>
+		constexpr matrix operator*(const matrix& another) const
+		{
+			return {
+				m11 * another.m11 + m12 * another.m21,
+				m11 * another.m12 + m12 * another.m22,
+				m21 * another.m11 + m22 * another.m21,
+				m21 * another.m12 + m22 * another.m22,
+				dx * another.m11 + dy * another.m21 + another.dx,
+				dx * another.m12 + dy * another.m22 + another.dy };
+		}
+		constexpr real transform_x(real x, real y) const
+		{
+			return x * m11 + y * m21 + dx;
+		}
+		constexpr real transform_y(real x, real y) const
+		{
+			return x * m12 + y * m22 + dy;
+		}
+		constexpr bool is_axis_aligned() const
+		{
+			return m12 == 0 && m21 == 0;
+		}
+		constexpr real determinant() const
+		{
+			return m11 * m22 - m12 * m21;
+		}
+		constexpr matrix inverse() const
+		{
+			real det = determinant();
+			if (!det)
+				return {};
+			return {
+				m22 / det, -m12 / det,
+				-m21 / det, m11 / det,
+				(m21 * dy - m22 * dx) / det,
+				(m12 * dx - m11 * dy) / det };
+		}
+
+#if _MSVC_LANG
+	public:
+		operator D2D1_MATRIX_3X2_F() const
+		{
+			return { m11, m12, m21, m22, dx, dy };
+		}
+#endif
+	};
+}
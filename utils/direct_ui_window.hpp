@@ -16,6 +16,7 @@ namespace direct_ui
 
 	private:
 		int capture_count{};
+		bool is_tracking_mouse{};
 
 	private:
 		virtual INT_PTR WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam) override final
@@ -35,6 +36,7 @@ namespace direct_ui
 			}
 			case WM_PAINT:
 			{
+				builtin_scene->dispatch_input();
 				builtin_scene->on_paint();
 				ValidateRect(hwnd, nullptr);
 				return 0;
@@ -44,6 +46,7 @@ namespace direct_ui
 				HANDLE_WM_SIZE(hwnd, wParam, lParam,
 					[this](HWND hwnd, UINT state, int cx, int cy)
 					{
+						builtin_scene->dispatch_input();
 						builtin_scene->resize(cx, cy, dpi() * USER_DEFAULT_SCREEN_DPI + 0.5);
 					});
 				break;
@@ -53,19 +56,23 @@ namespace direct_ui
 				HANDLE_WM_MOUSEMOVE(hwnd, wParam, lParam,
 					[this](HWND hwnd, int x, int y, UINT keyFlags)
 					{
-						TRACKMOUSEEVENT tme{ sizeof(tme) };
-						tme.hwndTrack = hwnd;
-						tme.dwFlags = TME_LEAVE;
-						tme.dwHoverTime = 0;
-						TrackMouseEvent(&tme);
-						builtin_scene->on_mouse_move(x, y);
+						if (!is_tracking_mouse)
+						{
+							TRACKMOUSEEVENT tme{ sizeof(tme) };
+							tme.hwndTrack = hwnd;
+							tme.dwFlags = TME_LEAVE;
+							tme.dwHoverTime = 0;
+							is_tracking_mouse = TrackMouseEvent(&tme);
+						}
+						builtin_scene->post_input(input_queue::event_type::mouse_move, x, y);
 						InvalidateRect(hwnd, nullptr, FALSE);
 					});
 				break;
 			}
 			case WM_MOUSELEAVE:
 			{
-				builtin_scene->on_mouse_leave();
+				is_tracking_mouse = false;
+				builtin_scene->post_input(input_queue::event_type::mouse_leave);
 				InvalidateRect(hwnd, nullptr, FALSE);
 				break;
 			}
@@ -76,7 +83,7 @@ namespace direct_ui
 					{
 						if (!(capture_count++))
 							SetCapture(hwnd);
-						builtin_scene->on_left_down(x, y);
+						builtin_scene->post_input(input_queue::event_type::left_down, x, y);
 						InvalidateRect(hwnd, nullptr, FALSE);
 					});
 				break;
@@ -86,7 +93,7 @@ namespace direct_ui
 				HANDLE_WM_LBUTTONUP(hwnd, wParam, lParam,
 					[this](HWND hwnd, int x, int y, UINT keyFlags)
 					{
-						builtin_scene->on_left_up(x, y);
+						builtin_scene->post_input(input_queue::event_type::left_up, x, y);
 						if (!(--capture_count))
 							ReleaseCapture();
 						InvalidateRect(hwnd, nullptr, FALSE);
@@ -100,7 +107,7 @@ namespace direct_ui
 					{
 						if (!(capture_count++))
 							SetCapture(hwnd);
-						builtin_scene->on_mid_down(x, y);
+						builtin_scene->post_input(input_queue::event_type::mid_down, x, y);
 						InvalidateRect(hwnd, nullptr, FALSE);
 					});
 				break;
@@ -110,7 +117,7 @@ namespace direct_ui
 				HANDLE_WM_LBUTTONUP(hwnd, wParam, lParam,
 					[this](HWND hwnd, int x, int y, UINT keyFlags)
 					{
-						builtin_scene->on_mid_up(x, y);
+						builtin_scene->post_input(input_queue::event_type::mid_up, x, y);
 						if (!(--capture_count))
 							ReleaseCapture();
 						InvalidateRect(hwnd, nullptr, FALSE);
@@ -124,7 +131,7 @@ namespace direct_ui
 					{
 						if (!(capture_count++))
 							SetCapture(hwnd);
-						builtin_scene->on_right_down(x, y);
+						builtin_scene->post_input(input_queue::event_type::right_down, x, y);
 						InvalidateRect(hwnd, nullptr, FALSE);
 					});
 				break;
@@ -134,7 +141,7 @@ namespace direct_ui
 				HANDLE_WM_LBUTTONUP(hwnd, wParam, lParam,
 					[this](HWND hwnd, int x, int y, UINT keyFlags)
 					{
-						builtin_scene->on_right_up(x, y);
+						builtin_scene->post_input(input_queue::event_type::right_up, x, y);
 						if (!(--capture_count))
 							ReleaseCapture();
 						InvalidateRect(hwnd, nullptr, FALSE);
@@ -143,12 +150,14 @@ namespace direct_ui
 			}
 			case WM_SETFOCUS:
 			{
+				builtin_scene->dispatch_input();
 				builtin_scene->on_set_focus();
 				InvalidateRect(hwnd, nullptr, FALSE);
 				break;
 			}
 			case WM_KILLFOCUS:
 			{
+				builtin_scene->dispatch_input();
 				builtin_scene->on_kill_focus();
 				InvalidateRect(hwnd, nullptr, FALSE);
 				break;
@@ -0,0 +1,283 @@
+﻿#pragma once
+
+#include <vector>
+#include <string_view>
+#include <span>
+
+#include "direct_ui_types.hpp"
+#include "packed_color.hpp"
+
+namespace direct_ui
+{
+	enum class text_align : unsigned char
+	{
+		leading,
+		center,
+		trailing,
+	};
+	/// <summary>
+	/// 文字格式。family 只在录制时被读取，不需要长期有效。
+	/// </summary>
+	struct text_format
+	{
+		std::wstring_view family{ L"Segoe UI" };
+		real size{ 14 };
+		unsigned short weight{ 400 };
+		text_align align{ text_align::center };
+		text_align paragraph_align{ text_align::center };
+	};
+
+	/// <summary>
+	/// 批量绘制的实心圆。颜色已预乘，后端不必逐个转换。
+	/// </summary>
+	struct circle_instance
+	{
+		real x;
+		real y;
+		real r;
+		packed_color brush;
+	};
+
+	/// <summary>
+	/// 保留模式的绘制命令缓冲。控件录制命令，场景将其拼接后交给后端回放。
+	/// </summary>
+	class display_list
+	{
+	public:
+		enum class command_type : unsigned char
+		{
+			fill_rect,
+			draw_rect,
+			fill_ellipse,
+			fill_circles,
+			draw_text,
+			push_clip,
+			pop_clip,
+			push_transform,
+			pop_transform,
+			begin_layer,
+			end_layer,
+			draw_layer,
+		};
+		/// <summary>
+		/// 定长命令。v 的含义取决于 type：
+		/// 矩形为 left, top, right, bottom, stroke；椭圆为 x, y, rx, ry；
+		/// 文字为布局矩形与字号；变换为 m11, m12, m21, m22, dx, dy；层为宽与高。
+		/// 文字的内容与字体名保存在字符池中，以偏移和长度引用；层命令的 text 保存层编号。
+		/// 批量圆保存在实例池中，text 与 text_length 为其偏移和个数。
+		/// </summary>
+		struct command
+		{
+			command_type type{};
+			text_align align{};
+			text_align paragraph_align{};
+			unsigned short weight{};
+			real v[6]{};
+			color brush{};
+			unsigned text{};
+			unsigned text_length{};
+			unsigned family{};
+			unsigned family_length{};
+		};
+
+		/// <summary>
+		/// 合成一帧时实际绘制与被剔除的控件数，由组在合成子控件时累加。
+		/// </summary>
+		struct compose_statistics
+		{
+			size_t painted{};
+			size_t culled{};
+		};
+		compose_statistics composed;
+
+	private:
+		std::vector<command> _commands;
+		std::vector<wchar_t> chars;
+		std::vector<circle_instance> instances;
+
+		unsigned store(std::wstring_view str)
+		{
+			auto ret = static_cast<unsigned>(chars.size());
+			chars.insert(chars.end(), str.begin(), str.end());
+			return ret;
+		}
+
+	public:
+		const std::vector<command>& commands() const { return _commands; }
+		std::wstring_view text(const command& c) const
+		{
+			return { chars.data() + c.text, c.text_length };
+		}
+		std::wstring_view family(const command& c) const
+		{
+			return { chars.data() + c.family, c.family_length };
+		}
+		std::span<const circle_instance> circles(const command& c) const
+		{
+			return { instances.data() + c.text, c.text_length };
+		}
+		bool empty() const { return _commands.empty(); }
+		size_t size() const { return _commands.size(); }
+		size_t heap_footprint() const
+		{
+			return _commands.capacity() * sizeof(command) + chars.capacity() * sizeof(wchar_t) +
+				instances.capacity() * sizeof(circle_instance);
+		}
+		void clear()
+		{
+			_commands.clear();
+			chars.clear();
+			instances.clear();
+			composed = {};
+		}
+
+	public:
+		void fill_rect(real left, real top, real right, real bottom, const color& brush)
+		{
+			command c{ command_type::fill_rect };
+			c.v[0] = left;
+			c.v[1] = top;
+			c.v[2] = right;
+			c.v[3] = bottom;
+			c.brush = brush;
+			_commands.push_back(c);
+		}
+		void draw_rect(real left, real top, real right, real bottom, const color& brush, real stroke)
+		{
+			command c{ command_type::draw_rect };
+			c.v[0] = left;
+			c.v[1] = top;
+			c.v[2] = right;
+			c.v[3] = bottom;
+			c.v[4] = stroke;
+			c.brush = brush;
+			_commands.push_back(c);
+		}
+		void fill_ellipse(real x, real y, real rx, real ry, const color& brush)
+		{
+			command c{ command_type::fill_ellipse };
+			c.v[0] = x;
+			c.v[1] = y;
+			c.v[2] = rx;
+			c.v[3] = ry;
+			c.brush = brush;
+			_commands.push_back(c);
+		}
+		/// <summary>
+		/// 实心圆。紧接着录制的圆合并为同一条命令，由后端一次绘制。
+		/// </summary>
+		void fill_circle(real x, real y, real r, packed_color brush)
+		{
+			if (_commands.empty() || _commands.back().type != command_type::fill_circles)
+			{
+				command c{ command_type::fill_circles };
+				c.text = static_cast<unsigned>(instances.size());
+				_commands.push_back(c);
+			}
+			instances.push_back({ x, y, r, brush });
+			_commands.back().text_length++;
+		}
+		void draw_text(std::wstring_view str, const text_format& format,
+			real left, real top, real right, real bottom, const color& brush)
+		{
+			command c{ command_type::draw_text };
+			c.align = format.align;
+			c.paragraph_align = format.paragraph_align;
+			c.weight = format.weight;
+			c.v[0] = left;
+			c.v[1] = top;
+			c.v[2] = right;
+			c.v[3] = bottom;
+			c.v[4] = format.size;
+			c.brush = brush;
+			c.text = store(str);
+			c.text_length = static_cast<unsigned>(str.length());
+			c.family = store(format.family);
+			c.family_length = static_cast<unsigned>(format.family.length());
+			_commands.push_back(c);
+		}
+		void push_clip(real left, real top, real right, real bottom)
+		{
+			command c{ command_type::push_clip };
+			c.v[0] = left;
+			c.v[1] = top;
+			c.v[2] = right;
+			c.v[3] = bottom;
+			_commands.push_back(c);
+		}
+		void pop_clip()
+		{
+			_commands.push_back({ command_type::pop_clip });
+		}
+		void push_transform(const matrix& m)
+		{
+			command c{ command_type::push_transform };
+			c.v[0] = m.m11;
+			c.v[1] = m.m12;
+			c.v[2] = m.m21;
+			c.v[3] = m.m22;
+			c.v[4] = m.dx;
+			c.v[5] = m.dy;
+			_commands.push_back(c);
+		}
+		void pop_transform()
+		{
+			_commands.push_back({ command_type::pop_transform });
+		}
+		/// <summary>
+		/// 之后的命令绘制到离屏层上，直到 end_layer。层内坐标以层的左上角为原点。
+		/// </summary>
+		void begin_layer(unsigned layer, real width, real height)
+		{
+			command c{ command_type::begin_layer };
+			c.v[0] = width;
+			c.v[1] = height;
+			c.text = layer;
+			_commands.push_back(c);
+		}
+		void end_layer()
+		{
+			_commands.push_back({ command_type::end_layer });
+		}
+		/// <summary>
+		/// 以当前变换将离屏层合成到目标上。
+		/// </summary>
+		void draw_layer(unsigned layer, real width, real height)
+		{
+			command c{ command_type::draw_layer };
+			c.v[0] = width;
+			c.v[1] = height;
+			c.text = layer;
+			_commands.push_back(c);
+		}
+
+	public:
+		/// <summary>
+		/// 将另一个列表的命令整体追加到末尾。只需修正文字命令的字符池偏移与批量圆的实例池偏移。
+		/// </summary>
+		void append(const display_list& another)
+		{
+			auto base = static_cast<unsigned>(chars.size());
+			auto instance_base = static_cast<unsigned>(instances.size());
+			auto first = _commands.size();
+			chars.insert(chars.end(), another.chars.begin(), another.chars.end());
+			instances.insert(instances.end(), another.instances.begin(), another.instances.end());
+			_commands.insert(_commands.end(), another._commands.begin(), another._commands.end());
+			if (base || instance_base)
+				for (auto i = first; i < _commands.size(); i++)
+				{
+					if (_commands[i].type == command_type::draw_text)
+					{
+						_commands[i].text += base;
+						_commands[i].family += base;
+					}
+					else if (_commands[i].type == command_type::fill_circles)
+						_commands[i].text += instance_base;
+				}
+		}
+		static matrix to_matrix(const command& c)
+		{
+			return { c.v[0], c.v[1], c.v[2], c.v[3], c.v[4], c.v[5] };
+		}
+	};
+}
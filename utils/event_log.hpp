@@ -0,0 +1,247 @@
+﻿#pragma once
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstdint>
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 进入场景的事件流的紧凑二进制记录，用于复现界面性能问题。
+	/// 格式：魔数 "DUIR"、版本号，之后每条记录为类型字节、距上一条的微秒数和参数，整数均为变长编码。
+	/// </summary>
+	class event_log
+	{
+	public:
+		static constexpr std::uint8_t version = 1;
+		enum class event_type : std::uint8_t
+		{
+			mouse_move,
+			mouse_leave,
+			left_down,
+			left_up,
+			mid_down,
+			mid_up,
+			right_down,
+			right_up,
+			resize, // a, b, c 为像素宽、高和 DPI。
+			set_focus,
+			kill_focus,
+			update, // a 为本次推进的时长（微秒）。
+			paint, // 一帧结束。
+		};
+		struct event
+		{
+			event_type type;
+			std::chrono::microseconds time; // 距记录开始的时间。
+			std::int64_t a{};
+			std::int64_t b{};
+			std::int64_t c{};
+		};
+
+	private:
+		std::vector<std::uint8_t> bytes{ 'D', 'U', 'I', 'R', version };
+		std::chrono::microseconds last{};
+		size_t _size{};
+
+		static constexpr size_t header_size = 5;
+		static size_t argument_count(event_type type)
+		{
+			using enum event_type;
+			switch (type)
+			{
+			case mouse_move: case left_down: case left_up: case mid_down:
+			case mid_up: case right_down: case right_up:
+				return 2;
+			case resize:
+				return 3;
+			case update:
+				return 1;
+			default:
+				return 0;
+			}
+		}
+		void write(std::uint64_t v)
+		{
+			while (v >= 0x80)
+			{
+				bytes.push_back(static_cast<std::uint8_t>(v | 0x80));
+				v >>= 7;
+			}
+			bytes.push_back(static_cast<std::uint8_t>(v));
+		}
+		static bool read(const std::vector<std::uint8_t>& bytes, size_t& pos, std::uint64_t& v)
+		{
+			v = 0;
+			for (int shift = 0; shift < 64 && pos < bytes.size(); shift += 7)
+			{
+				auto byte = bytes[pos++];
+				v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+				if (!(byte & 0x80))
+					return true;
+			}
+			return false;
+		}
+		static std::uint64_t zigzag(std::int64_t v)
+		{
+			return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+		}
+		static std::int64_t unzigzag(std::uint64_t v)
+		{
+			return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+		}
+
+	public:
+		event_log() = default;
+		/// <summary>
+		/// 从字节恢复记录。格式或版本不符时抛出 std::runtime_error。
+		/// </summary>
+		explicit event_log(std::vector<std::uint8_t> data) : bytes(std::move(data))
+		{
+			if (bytes.size() < header_size || bytes[0] != 'D' || bytes[1] != 'U' ||
+				bytes[2] != 'I' || bytes[3] != 'R' || bytes[4] != version)
+				throw std::runtime_error("Invalid event log.");
+			for (const auto& e : *this)
+			{
+				last = e.time;
+				_size++;
+			}
+		}
+
+	public:
+		/// <summary>
+		/// 追加一条记录。时间不得早于上一条。
+		/// </summary>
+		void push(const event& e)
+		{
+			auto time = e.time < last ? last : e.time;
+			bytes.push_back(static_cast<std::uint8_t>(e.type));
+			write(static_cast<std::uint64_t>((time - last).count()));
+			std::int64_t args[]{ e.a, e.b, e.c };
+			for (size_t i = 0; i < argument_count(e.type); i++)
+				write(zigzag(args[i]));
+			last = time;
+			_size++;
+		}
+		size_t size() const { return _size; }
+		bool empty() const { return !_size; }
+		const std::vector<std::uint8_t>& data() const { return bytes; }
+		/// <summary>
+		/// 总时长，即最后一条记录的时间。
+		/// </summary>
+		std::chrono::microseconds duration() const { return last; }
+
+	public:
+		/// <summary>
+		/// 顺序解码记录。遇到截断的记录时停止。
+		/// </summary>
+		class iterator
+		{
+			const std::vector<std::uint8_t>* bytes{};
+			size_t pos{};
+			event current{};
+			bool valid{};
+
+			void decode()
+			{
+				valid = false;
+				if (!bytes || pos >= bytes->size())
+					return;
+				auto type = (*bytes)[pos++];
+				if (type > static_cast<std::uint8_t>(event_type::paint))
+					return;
+				current.type = static_cast<event_type>(type);
+				std::uint64_t v;
+				if (!read(*bytes, pos, v))
+					return;
+				current.time += std::chrono::microseconds(static_cast<std::int64_t>(v));
+				std::int64_t* args[]{ &current.a, &current.b, &current.c };
+				for (size_t i = 0; i < 3; i++)
+				{
+					*args[i] = 0;
+					if (i < argument_count(current.type))
+					{
+						if (!read(*bytes, pos, v))
+							return;
+						*args[i] = unzigzag(v);
+					}
+				}
+				valid = true;
+			}
+
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = event;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const event*;
+			using reference = const event&;
+
+			iterator() = default;
+			iterator(const std::vector<std::uint8_t>& bytes) : bytes(&bytes), pos(header_size)
+			{
+				decode();
+			}
+			reference operator*() const { return current; }
+			pointer operator->() const { return &current; }
+			iterator& operator++()
+			{
+				decode();
+				return *this;
+			}
+			void operator++(int) { decode(); }
+			bool operator==(const iterator& another) const
+			{
+				return valid == another.valid && (!valid || pos == another.pos);
+			}
+		};
+		iterator begin() const { return iterator(bytes); }
+		iterator end() const { return {}; }
+
+	public:
+		void save(const std::string& path) const
+		{
+			std::ofstream fs(path, std::ios::binary);
+			if (!fs)
+				throw std::runtime_error("Fail to open event log for writing.");
+			fs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		}
+		static event_log load(const std::string& path)
+		{
+			std::ifstream fs(path, std::ios::binary);
+			if (!fs)
+				throw std::runtime_error("Fail to open event log for reading.");
+			return event_log(std::vector<std::uint8_t>(std::istreambuf_iterator<char>(fs), {}));
+		}
+	};
+
+	/// <summary>
+	/// 记录场景收到的事件。计时器线程的推进与界面线程的输入可能同时到达，内部加锁。
+	/// </summary>
+	class event_recorder
+	{
+		mutable std::mutex mutex;
+		event_log log;
+		std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+
+	public:
+		void record(event_log::event_type type, std::int64_t a = 0, std::int64_t b = 0, std::int64_t c = 0)
+		{
+			auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			std::lock_guard<std::mutex> lck(mutex);
+			log.push({ type, time, a, b, c });
+		}
+		/// <summary>
+		/// 取得到目前为止的记录副本。
+		/// </summary>
+		event_log snapshot() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			return log;
+		}
+	};
+}
@@ -0,0 +1,129 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <concepts>
+
+#include "direct_ui.hpp"
+#include "event_log.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 一组逐帧耗时的分布，单位为微秒。
+	/// </summary>
+	struct frame_time_statistics
+	{
+		size_t frames{};
+		double mean{};
+		double p50{};
+		double p90{};
+		double p99{};
+		double max{};
+
+		static frame_time_statistics of(std::vector<double> samples)
+		{
+			frame_time_statistics ret;
+			if (samples.empty())
+				return ret;
+			std::sort(samples.begin(), samples.end());
+			auto rank = [&](double p)
+			{
+				auto i = static_cast<size_t>(p * samples.size() + 0.999999);
+				return samples[std::clamp<size_t>(i, 1, samples.size()) - 1];
+			};
+			ret.frames = samples.size();
+			ret.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+			ret.p50 = rank(0.5);
+			ret.p90 = rank(0.9);
+			ret.p99 = rank(0.99);
+			ret.max = samples.back();
+			return ret;
+		}
+	};
+	/// <summary>
+	/// 回放结果。一帧以一次绘制结束，输入与推进的耗时计入其后的那一帧。
+	/// </summary>
+	struct replay_report
+	{
+		size_t events{};
+		frame_time_statistics input;
+		frame_time_statistics update;
+		frame_time_statistics paint;
+	};
+
+	/// <summary>
+	/// 将记录的事件依次送入场景，并统计每帧的耗时。会停用场景的计时器，推进只来自记录。
+	/// </summary>
+	inline replay_report replay_events(scene& s, const event_log& log)
+	{
+		using clock = std::chrono::steady_clock;
+		s.set_manual_update(true);
+
+		replay_report ret;
+		std::vector<double> input_times, update_times, paint_times;
+		double frame_input{}, frame_update{};
+		for (const auto& e : log)
+		{
+			ret.events++;
+			auto begin = clock::now();
+			switch (e.type)
+			{
+				using enum event_log::event_type;
+			case mouse_move: s.on_mouse_move(static_cast<int>(e.a), static_cast<int>(e.b)); break;
+			case mouse_leave: s.on_mouse_leave(); break;
+			case left_down: s.on_left_down(static_cast<int>(e.a), static_cast<int>(e.b)); break;
+			case left_up: s.on_left_up(static_cast<int>(e.a), static_cast<int>(e.b)); break;
+			case mid_down: s.on_mid_down(static_cast<int>(e.a), static_cast<int>(e.b)); break;
+			case mid_up: s.on_mid_up(static_cast<int>(e.a), static_cast<int>(e.b)); break;
+			case right_down: s.on_right_down(static_cast<int>(e.a), static_cast<int>(e.b)); break;
+			case right_up: s.on_right_up(static_cast<int>(e.a), static_cast<int>(e.b)); break;
+			case resize: s.resize(static_cast<int>(e.a), static_cast<int>(e.b), static_cast<int>(e.c)); break;
+			case set_focus: s.on_set_focus(); break;
+			case kill_focus: s.on_kill_focus(); break;
+			case update: s.on_update(std::chrono::microseconds(e.a)); break;
+			case paint: s.on_paint(); break;
+			}
+			double us = std::chrono::duration<double, std::micro>(clock::now() - begin).count();
+			if (e.type == event_log::event_type::update)
+				frame_update += us;
+			else if (e.type == event_log::event_type::paint)
+			{
+				input_times.push_back(frame_input);
+				update_times.push_back(frame_update);
+				paint_times.push_back(us);
+				frame_input = frame_update = 0;
+			}
+			else
+				frame_input += us;
+		}
+		ret.input = frame_time_statistics::of(std::move(input_times));
+		ret.update = frame_time_statistics::of(std::move(update_times));
+		ret.paint = frame_time_statistics::of(std::move(paint_times));
+		return ret;
+	}
+	/// <summary>
+	/// 按记录开头的尺寸构造无窗口场景，交给 setup 搭建控件后回放。
+	/// setup 应与录制时搭建界面的代码相同。
+	/// </summary>
+	template <typename setup_t>
+	replay_report replay_headless(scene_factory& factory, const event_log& log, setup_t&& setup,
+		std::shared_ptr<glyph_source> glyphs = std::make_shared<box_glyph_source>())
+		requires std::invocable<setup_t, const std::shared_ptr<scene>&>
+	{
+		int width = 1, height = 1, dpi = render_backend::default_dpi;
+		if (auto it = log.begin(); it != log.end() && it->type == event_log::event_type::resize)
+		{
+			width = static_cast<int>(it->a);
+			height = static_cast<int>(it->b);
+			dpi = static_cast<int>(it->c);
+		}
+		auto s = factory.build_soft_scene(width, height, dpi, std::move(glyphs));
+		s->set_manual_update(true);
+		setup(s);
+		return replay_events(*s, log);
+	}
+}
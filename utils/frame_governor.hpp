@@ -0,0 +1,231 @@
+﻿#pragma once
+
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 超出帧预算时可以采取的降级措施，按声明顺序逐级启用。
+	/// </summary>
+	enum class frame_degradation : std::uint8_t
+	{
+		skip_effects, // 不再产生新的装饰效果（如按钮波纹）。
+		lower_tick_rate, // 计时器间隔乘以 tick_divisor。
+		defer_low_priority, // 低优先级控件的更新每 low_priority_period 帧才执行一次。
+	};
+
+	/// <summary>
+	/// 帧预算与降级策略。
+	/// </summary>
+	struct frame_budget
+	{
+		std::chrono::nanoseconds budget{ std::chrono::milliseconds(10) };
+		std::chrono::nanoseconds tick{ std::chrono::milliseconds(10) };
+		bool skip_effects{ true };
+		bool lower_tick_rate{ true };
+		bool defer_low_priority{ true };
+		unsigned tick_divisor{ 2 };
+		unsigned low_priority_period{ 4 };
+		unsigned overload_frames{ 3 }; // 连续超出预算这么多帧后加重一级。
+		unsigned recovery_frames{ 30 }; // 连续低于 recovery_ratio 倍预算这么多帧后减轻一级。
+		double recovery_ratio{ 0.6 };
+	};
+
+	/// <summary>
+	/// 帧预算调控器的计数。
+	/// </summary>
+	struct frame_governor_statistics
+	{
+		size_t frames{};
+		size_t over_budget_frames{};
+		size_t degrade_steps{};
+		size_t recover_steps{};
+		size_t skipped_effects{};
+		size_t deferred_updates{};
+		unsigned level{}; // 当前启用的降级措施个数。
+		std::chrono::nanoseconds update{}; // 最近画完的一帧各阶段的耗时。
+		std::chrono::nanoseconds layout{};
+		std::chrono::nanoseconds compose{};
+		std::chrono::nanoseconds render{};
+	};
+
+	/// <summary>
+	/// 帧预算调控器。场景在各阶段结束时报告耗时，每帧画完后比较总耗时与预算，
+	/// 连续超出时逐级启用降级措施，负载下降后逐级撤销。阶段可能在不同线程上报告。
+	/// </summary>
+	class frame_governor
+	{
+	public:
+		enum class phase : std::uint8_t
+		{
+			update,
+			layout,
+			compose,
+			render,
+		};
+	private:
+		mutable std::mutex mutex;
+		frame_budget policy;
+		frame_degradation steps[3]{};
+		unsigned step_count{};
+		std::atomic<std::int64_t> phase_time[4]{};
+		std::atomic<unsigned> _level{};
+		std::atomic<bool> _enabled{};
+		std::atomic<size_t> _skipped_effects{};
+		std::atomic<size_t> _deferred_updates{};
+		unsigned over_count{};
+		unsigned under_count{};
+		frame_governor_statistics stats;
+
+	public:
+		/// <summary>
+		/// 启用调控。未启用时不降级，只统计。
+		/// </summary>
+		void set_policy(const frame_budget& budget)
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			policy = budget;
+			step_count = 0;
+			if (policy.skip_effects)
+				steps[step_count++] = frame_degradation::skip_effects;
+			if (policy.lower_tick_rate && policy.tick_divisor > 1)
+				steps[step_count++] = frame_degradation::lower_tick_rate;
+			if (policy.defer_low_priority && policy.low_priority_period > 1)
+				steps[step_count++] = frame_degradation::defer_low_priority;
+			over_count = under_count = 0;
+			_level = 0;
+			_enabled = true;
+		}
+		void disable()
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			_enabled = false;
+			_level = 0;
+		}
+		bool is_enabled() const
+		{
+			return _enabled;
+		}
+		/// <summary>
+		/// 某项降级措施当前是否启用。
+		/// </summary>
+		bool is_active(frame_degradation d) const
+		{
+			unsigned level = _level;
+			if (!level)
+				return false;
+			std::lock_guard<std::mutex> lck(mutex);
+			for (unsigned i = 0; i < level && i < step_count; i++)
+				if (steps[i] == d)
+					return true;
+			return false;
+		}
+		std::chrono::nanoseconds tick_interval() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			auto ret = policy.tick;
+			for (unsigned i = 0; i < _level && i < step_count; i++)
+				if (steps[i] == frame_degradation::lower_tick_rate)
+					ret *= policy.tick_divisor;
+			return ret;
+		}
+		unsigned low_priority_period() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			return policy.low_priority_period;
+		}
+
+	public:
+		/// <summary>
+		/// 累加一个阶段的耗时。同一阶段在一帧内可能执行多次（如更新与绘制之前都会解析布局）。
+		/// </summary>
+		void report(phase p, std::chrono::nanoseconds time)
+		{
+			phase_time[static_cast<size_t>(p)] += time.count();
+		}
+		void count_skipped_effect()
+		{
+			_skipped_effects++;
+		}
+		void count_deferred_update()
+		{
+			_deferred_updates++;
+		}
+		/// <summary>
+		/// 一帧画完后调用，据最近报告的各阶段耗时调整降级等级。
+		/// </summary>
+		void end_frame()
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			std::chrono::nanoseconds times[4];
+			for (size_t i = 0; i < 4; i++)
+				times[i] = std::chrono::nanoseconds(phase_time[i].exchange(0));
+			auto total = times[0] + times[1] + times[2] + times[3];
+			stats.update = times[0];
+			stats.layout = times[1];
+			stats.compose = times[2];
+			stats.render = times[3];
+			stats.frames++;
+			bool over = total > policy.budget;
+			stats.over_budget_frames += over;
+			if (!_enabled)
+				return;
+			unsigned level = _level;
+			if (over)
+			{
+				under_count = 0;
+				if (++over_count >= policy.overload_frames && level < step_count)
+				{
+					_level = level + 1;
+					stats.degrade_steps++;
+					over_count = 0;
+				}
+			}
+			else
+			{
+				over_count = 0;
+				if (total < policy.budget * policy.recovery_ratio)
+				{
+					if (++under_count >= policy.recovery_frames && level)
+					{
+						_level = level - 1;
+						stats.recover_steps++;
+						under_count = 0;
+					}
+				}
+				else
+					under_count = 0;
+			}
+		}
+		frame_governor_statistics statistics() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			auto ret = stats;
+			ret.skipped_effects = _skipped_effects;
+			ret.deferred_updates = _deferred_updates;
+			ret.level = _level;
+			return ret;
+		}
+	};
+
+	/// <summary>
+	/// 在作用域结束时向调控器报告经过的时间。
+	/// </summary>
+	class frame_phase_timer
+	{
+		frame_governor& governor;
+		frame_governor::phase p;
+		std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+	public:
+		frame_phase_timer(frame_governor& governor, frame_governor::phase p) : governor(governor), p(p) {}
+		frame_phase_timer(const frame_phase_timer&) = delete;
+		frame_phase_timer& operator=(const frame_phase_timer&) = delete;
+		~frame_phase_timer()
+		{
+			governor.report(p, std::chrono::steady_clock::now() - start);
+		}
+	};
+}
@@ -0,0 +1,405 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <functional>
+
+#include "direct_ui_types.hpp"
+#include "resource_cache.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 为软件光栅化提供字形覆盖率位图。
+	/// </summary>
+	class glyph_source
+	{
+	public:
+		struct glyph
+		{
+			int width{};
+			int height{};
+			int left{}; // 位图左边缘相对笔位置的偏移。
+			int top{}; // 位图上边缘相对基线的高度，向上为正。
+			std::vector<unsigned char> coverage;
+		};
+		struct font_metrics
+		{
+			real ascent{};
+			real descent{};
+		};
+	public:
+		virtual ~glyph_source() {}
+		virtual font_metrics metrics(std::wstring_view family, real size) = 0;
+		virtual real advance(char32_t code_point, std::wstring_view family, unsigned short weight, real size) = 0;
+		virtual void rasterize(char32_t code_point, std::wstring_view family, unsigned short weight, real size, glyph& out) = 0;
+		/// <summary>
+		/// 以笔位置右移 offset_x（0 到 1 像素）光栅化。默认实现对整像素位图做水平线性插值，位图加宽一列。
+		/// </summary>
+		virtual void rasterize_subpixel(char32_t code_point, std::wstring_view family, unsigned short weight, real size,
+			real offset_x, glyph& out)
+		{
+			rasterize(code_point, family, weight, size, out);
+			auto f = static_cast<unsigned>(offset_x * 256 + 0.5f);
+			if (!f || !out.width || !out.height)
+				return;
+			if (f >= 256)
+			{
+				out.left++;
+				return;
+			}
+			std::vector<unsigned char> shifted(static_cast<size_t>(out.width + 1) * out.height);
+			for (int y = 0; y < out.height; y++)
+			{
+				const unsigned char* src = out.coverage.data() + static_cast<size_t>(y) * out.width;
+				unsigned char* dst = shifted.data() + static_cast<size_t>(y) * (out.width + 1);
+				unsigned prev = 0;
+				for (int x = 0; x <= out.width; x++)
+				{
+					unsigned cur = x < out.width ? src[x] : 0;
+					dst[x] = static_cast<unsigned char>((cur * (256 - f) + prev * f + 128) >> 8);
+					prev = cur;
+				}
+			}
+			out.width++;
+			out.coverage = std::move(shifted);
+		}
+	};
+	/// <summary>
+	/// 不依赖字体文件的字形源，将每个字形画成空心方框。用于无字体环境下的布局与性能测试。
+	/// </summary>
+	class box_glyph_source : public glyph_source
+	{
+	public:
+		virtual font_metrics metrics([[maybe_unused]] std::wstring_view family, real size) override
+		{
+			return { size * 0.8f, size * 0.2f };
+		}
+		virtual real advance(char32_t code_point, [[maybe_unused]] std::wstring_view family, [[maybe_unused]] unsigned short weight, real size) override
+		{
+			return code_point < 0x2E80 ? size * 0.55f : size;
+		}
+		virtual void rasterize(char32_t code_point, std::wstring_view family, unsigned short weight, real size, glyph& out) override
+		{
+			if (code_point == U' ' || code_point == U'\t')
+			{
+				out.width = out.height = 0;
+				out.coverage.clear();
+				return;
+			}
+			real adv = advance(code_point, family, weight, size);
+			out.width = std::max(1, static_cast<int>(adv * 0.8f));
+			out.height = std::max(1, static_cast<int>(size * 0.7f));
+			out.left = static_cast<int>(adv * 0.1f);
+			out.top = out.height;
+			out.coverage.assign(static_cast<size_t>(out.width) * out.height, 0);
+			int pen = weight >= 600 ? 2 : 1;
+			for (int y = 0; y < out.height; y++)
+				for (int x = 0; x < out.width; x++)
+					if (x < pen || y < pen || x >= out.width - pen || y >= out.height - pen)
+						out.coverage[static_cast<size_t>(y) * out.width + x] = 255;
+		}
+	};
+
+	/// <summary>
+	/// 天际线装箱。记录每一列已占用的高度轮廓，新矩形放在能放下的最低处。
+	/// </summary>
+	class skyline_packer
+	{
+		struct segment
+		{
+			int x;
+			int y;
+			int width;
+		};
+		int _width;
+		int _height;
+		std::vector<segment> skyline;
+
+	public:
+		skyline_packer(int width, int height) : _width(width), _height(height)
+		{
+			reset();
+		}
+		void reset()
+		{
+			skyline.assign(1, { 0, 0, _width });
+		}
+		int width() const { return _width; }
+		int height() const { return _height; }
+
+	public:
+		/// <summary>
+		/// 放置 w × h 的矩形。放不下时返回 false。
+		/// </summary>
+		bool pack(int w, int h, int& out_x, int& out_y)
+		{
+			size_t best = skyline.size();
+			int best_y = INT_MAX;
+			int best_width = INT_MAX;
+			for (size_t i = 0; i < skyline.size(); i++)
+			{
+				int y = fit(i, w, h);
+				if (y >= 0 && (y < best_y || (y == best_y && skyline[i].width < best_width)))
+				{
+					best = i;
+					best_y = y;
+					best_width = skyline[i].width;
+				}
+			}
+			if (best == skyline.size())
+				return false;
+
+			out_x = skyline[best].x;
+			out_y = best_y;
+			skyline.insert(skyline.begin() + best, { out_x, best_y + h, w });
+			for (size_t i = best + 1; i < skyline.size();)
+			{
+				auto& prev = skyline[i - 1];
+				auto& cur = skyline[i];
+				int overlap = prev.x + prev.width - cur.x;
+				if (overlap <= 0)
+					break;
+				cur.x += overlap;
+				cur.width -= overlap;
+				if (cur.width > 0)
+					break;
+				skyline.erase(skyline.begin() + i);
+			}
+			for (size_t i = 1; i < skyline.size();)
+			{
+				if (skyline[i - 1].y == skyline[i].y)
+				{
+					skyline[i - 1].width += skyline[i].width;
+					skyline.erase(skyline.begin() + i);
+				}
+				else
+					i++;
+			}
+			return true;
+		}
+
+	private:
+		int fit(size_t i, int w, int h) const
+		{
+			if (skyline[i].x + w > _width)
+				return -1;
+			int y = 0;
+			for (int remaining = w; remaining > 0; i++)
+			{
+				y = std::max(y, skyline[i].y);
+				if (y + h > _height)
+					return -1;
+				remaining -= skyline[i].width;
+			}
+			return y;
+		}
+	};
+
+	/// <summary>
+	/// 字形图集。按（字体，字号，字形，亚像素偏移）缓存光栅化结果，用天际线装箱放进固定大小的覆盖率页中。
+	/// 页满且达到页数上限时，整页淘汰最久未使用的页。放不进一页的字形不缓存。
+	/// 不加锁，只在绘制线程使用。
+	/// </summary>
+	class glyph_atlas
+	{
+	public:
+		static constexpr int subpixel_steps = 4;
+		/// <summary>
+		/// 图集中一个字形的覆盖率位图。指针在下一次查找前有效。
+		/// </summary>
+		struct sample
+		{
+			const unsigned char* coverage{};
+			int stride{};
+			int width{};
+			int height{};
+			int left{};
+			int top{};
+		};
+
+	private:
+		static constexpr int padding = 1;
+		static constexpr size_t blank = SIZE_MAX; // 空白字形不占页。
+		struct key
+		{
+			std::uint32_t family;
+			std::uint32_t size; // 1/64 像素。
+			char32_t code_point;
+			std::uint16_t weight;
+			std::uint16_t subpixel;
+
+			bool operator==(const key&) const = default;
+		};
+		struct key_hash
+		{
+			size_t operator()(const key& k) const
+			{
+				std::uint64_t h = (static_cast<std::uint64_t>(k.family) << 32 | k.size) * 0x9E3779B97F4A7C15ull;
+				h ^= (static_cast<std::uint64_t>(k.code_point) << 32 |
+					static_cast<std::uint64_t>(k.weight) << 16 | k.subpixel) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+				return static_cast<size_t>(h);
+			}
+		};
+		struct entry
+		{
+			size_t page;
+			int x;
+			int y;
+			int width;
+			int height;
+			int left;
+			int top;
+		};
+		struct page
+		{
+			skyline_packer packer;
+			std::vector<unsigned char> coverage;
+			std::vector<key> keys;
+			std::uint64_t last_use{};
+		};
+
+		int _page_size;
+		size_t _max_pages;
+		std::vector<page> pages;
+		std::unordered_map<key, entry, key_hash> entries;
+		struct family_hash
+		{
+			using is_transparent = void;
+			size_t operator()(std::wstring_view family) const
+			{
+				return std::hash<std::wstring_view>()(family);
+			}
+		};
+		std::unordered_map<std::wstring, std::uint32_t, family_hash, std::equal_to<>> families;
+		std::uint64_t tick{};
+		cache_statistics stats;
+		size_t _evicted_pages{};
+		glyph_source::glyph scratch;
+
+	public:
+		glyph_atlas(int page_size = 256, size_t max_pages = 16) :
+			_page_size(page_size), _max_pages(max_pages ? max_pages : 1)
+		{
+		}
+
+	public:
+		/// <summary>
+		/// 取得字形位图，未命中时向 source 请求光栅化并放入图集。
+		/// </summary>
+		sample get(glyph_source& source, char32_t code_point, std::wstring_view family,
+			unsigned short weight, real size, int subpixel)
+		{
+			key k{ family_id(family), static_cast<std::uint32_t>(size * 64 + 0.5f),
+				code_point, weight, static_cast<std::uint16_t>(subpixel) };
+			tick++;
+			if (auto it = entries.find(k); it != entries.end())
+			{
+				stats.hits++;
+				auto& e = it->second;
+				if (e.page == blank)
+					return { nullptr, 0, 0, 0, e.left, e.top };
+				auto& p = pages[e.page];
+				p.last_use = tick;
+				return { p.coverage.data() + static_cast<size_t>(e.y) * _page_size + e.x,
+					_page_size, e.width, e.height, e.left, e.top };
+			}
+
+			stats.misses++;
+			source.rasterize_subpixel(code_point, family, weight, size,
+				static_cast<real>(subpixel) / subpixel_steps, scratch);
+			sample ret{ scratch.coverage.data(), scratch.width,
+				scratch.width, scratch.height, scratch.left, scratch.top };
+			if (!scratch.width || !scratch.height)
+			{
+				entries.emplace(k, entry{ blank, 0, 0, 0, 0, scratch.left, scratch.top });
+				return { nullptr, 0, 0, 0, scratch.left, scratch.top };
+			}
+
+			int x, y;
+			auto index = allocate(scratch.width + padding, scratch.height + padding, x, y);
+			if (index == pages.size())
+				return ret;
+			auto& p = pages[index];
+			p.last_use = tick;
+			p.keys.push_back(k);
+			for (int row = 0; row < scratch.height; row++)
+				std::copy_n(scratch.coverage.data() + static_cast<size_t>(row) * scratch.width, scratch.width,
+					p.coverage.data() + static_cast<size_t>(y + row) * _page_size + x);
+			entries.emplace(k, entry{ index, x, y, scratch.width, scratch.height, scratch.left, scratch.top });
+			return { p.coverage.data() + static_cast<size_t>(y) * _page_size + x,
+				_page_size, scratch.width, scratch.height, scratch.left, scratch.top };
+		}
+		void clear()
+		{
+			pages.clear();
+			entries.clear();
+		}
+
+	public:
+		/// <summary>
+		/// hits、misses 为字形查找次数；evictions 为随页淘汰的字形数；bytes 为覆盖率页占用的内存。
+		/// </summary>
+		cache_statistics statistics() const
+		{
+			auto ret = stats;
+			ret.entries = entries.size();
+			ret.bytes = pages.size() * static_cast<size_t>(_page_size) * _page_size;
+			return ret;
+		}
+		void reset_statistics()
+		{
+			stats = {};
+			_evicted_pages = 0;
+		}
+		size_t page_count() const { return pages.size(); }
+		size_t evicted_pages() const { return _evicted_pages; }
+		int page_size() const { return _page_size; }
+
+	private:
+		std::uint32_t family_id(std::wstring_view family)
+		{
+			if (auto it = families.find(family); it != families.end())
+				return it->second;
+			auto id = static_cast<std::uint32_t>(families.size());
+			families.emplace(std::wstring(family), id);
+			return id;
+		}
+		/// <summary>
+		/// 在某一页中分配空间，返回页号。字形比一页还大时返回 pages.size()。
+		/// </summary>
+		size_t allocate(int w, int h, int& x, int& y)
+		{
+			if (w > _page_size || h > _page_size)
+				return pages.size();
+			for (size_t i = 0; i < pages.size(); i++)
+				if (pages[i].packer.pack(w, h, x, y))
+					return i;
+			if (pages.size() < _max_pages)
+			{
+				pages.push_back({ skyline_packer(_page_size, _page_size),
+					std::vector<unsigned char>(static_cast<size_t>(_page_size) * _page_size), {}, 0 });
+				pages.back().packer.pack(w, h, x, y);
+				return pages.size() - 1;
+			}
+			auto victim = static_cast<size_t>(std::min_element(pages.begin(), pages.end(),
+				[](const page& a, const page& b) { return a.last_use < b.last_use; }) - pages.begin());
+			auto& p = pages[victim];
+			for (const auto& k : p.keys)
+				entries.erase(k);
+			stats.evictions += p.keys.size();
+			_evicted_pages++;
+			p.keys.clear();
+			p.packer.reset();
+			p.packer.pack(w, h, x, y);
+			return victim;
+		}
+	};
+}
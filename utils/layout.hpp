@@ -0,0 +1,435 @@
+﻿#pragma once
+
+#include <vector>
+#include <optional>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+
+#include "direct_ui_types.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 布局中的尺寸。不限制的方向用 unbounded 表示。
+	/// </summary>
+	struct layout_size
+	{
+		static constexpr real unbounded = std::numeric_limits<real>::infinity();
+		/// <summary>
+		/// 交给文字排版等需要有限尺寸的接口时，unbounded 换成的值。
+		/// </summary>
+		static constexpr real max_finite = 1 << 20;
+		static real finite(real v)
+		{
+			return v < max_finite ? v : max_finite;
+		}
+		real cx{};
+		real cy{};
+
+		bool operator==(const layout_size&) const = default;
+	};
+	struct layout_rect
+	{
+		real x{};
+		real y{};
+		real cx{};
+		real cy{};
+	};
+	struct layout_thickness
+	{
+		real left{};
+		real top{};
+		real right{};
+		real bottom{};
+
+		real horizontal() const { return left + right; }
+		real vertical() const { return top + bottom; }
+	};
+	/// <summary>
+	/// 在布局给出的格子中的对齐方式。stretch 填满格子。
+	/// </summary>
+	enum class layout_align : std::uint8_t
+	{
+		stretch,
+		leading,
+		center,
+		trailing,
+	};
+
+	/// <summary>
+	/// 子控件在所属组的布局中的参数。不同布局只读取各自需要的字段。
+	/// </summary>
+	struct layout_params
+	{
+		std::optional<real> cx; // 固定尺寸。未设置时使用测量结果。
+		std::optional<real> cy;
+		layout_thickness margin;
+		layout_align horizontal_align{};
+		layout_align vertical_align{};
+		real grow{}; // stack：按比例分得主轴上的剩余空间。
+		unsigned short row{}; // grid
+		unsigned short column{};
+		unsigned short row_span{ 1 };
+		unsigned short column_span{ 1 };
+		std::optional<real> left; // anchor：到组边缘的距离，相对的两边都设置时拉伸。
+		std::optional<real> top;
+		std::optional<real> right;
+		std::optional<real> bottom;
+	};
+
+	/// <summary>
+	/// 布局访问子控件的接口，由组实现。measure 的结果不含外边距，已缓存的结果不会重复测量。
+	/// </summary>
+	class layout_context
+	{
+	public:
+		virtual ~layout_context() {}
+		virtual size_t count() const = 0;
+		virtual const layout_params& params(size_t i) const = 0;
+		virtual layout_size measure(size_t i, layout_size available) = 0;
+		virtual void place(size_t i, const layout_rect& rect) = 0;
+	};
+
+	/// <summary>
+	/// 组的布局。measure 返回内容需要的尺寸，arrange 在给定尺寸内放置所有子控件。
+	/// 布局对象只保存配置，可以被多个组共享；修改配置后应调用组的 invalidate_layout。
+	/// </summary>
+	class layout
+	{
+	public:
+		virtual ~layout() {}
+		virtual layout_size measure(layout_context& ctx, layout_size available) = 0;
+		virtual void arrange(layout_context& ctx, layout_size size) = 0;
+
+	protected:
+		/// <summary>
+		/// 在一个方向上放置：返回起点与长度。
+		/// </summary>
+		static std::pair<real, real> align(layout_align a, real start, real space, real desired)
+		{
+			switch (a)
+			{
+			case layout_align::leading:
+				return { start, desired };
+			case layout_align::center:
+				return { start + (space - desired) / 2, desired };
+			case layout_align::trailing:
+				return { start + space - desired, desired };
+			default:
+				return { start, std::max<real>(space, 0) };
+			}
+		}
+		/// <summary>
+		/// 在格子内放置子控件，考虑外边距与对齐。
+		/// </summary>
+		static void place_in(layout_context& ctx, size_t i, real x, real y, real cx, real cy)
+		{
+			const auto& p = ctx.params(i);
+			auto desired = ctx.measure(i, { std::max<real>(cx - p.margin.horizontal(), 0),
+				std::max<real>(cy - p.margin.vertical(), 0) });
+			auto [left, width] = align(p.horizontal_align, x + p.margin.left, cx - p.margin.horizontal(), desired.cx);
+			auto [top, height] = align(p.vertical_align, y + p.margin.top, cy - p.margin.vertical(), desired.cy);
+			ctx.place(i, { left, top, width, height });
+		}
+		static real shrink(real available, real used)
+		{
+			return std::max<real>(available - used, 0);
+		}
+	};
+
+	/// <summary>
+	/// 沿一个方向依次排列。交叉方向按各自的对齐放置，主轴上的剩余空间按 grow 分配。
+	/// </summary>
+	class stack_layout : public layout
+	{
+	public:
+		enum class orientation : std::uint8_t
+		{
+			vertical,
+			horizontal,
+		};
+		orientation direction{};
+		real spacing{};
+		layout_thickness padding;
+
+		stack_layout() = default;
+		stack_layout(orientation direction, real spacing = 0, layout_thickness padding = {}) :
+			direction(direction), spacing(spacing), padding(padding) {}
+
+	private:
+		bool vertical() const { return direction == orientation::vertical; }
+		real main(layout_size s) const { return vertical() ? s.cy : s.cx; }
+		real cross(layout_size s) const { return vertical() ? s.cx : s.cy; }
+		real main_margin(const layout_params& p) const { return vertical() ? p.margin.vertical() : p.margin.horizontal(); }
+		real cross_margin(const layout_params& p) const { return vertical() ? p.margin.horizontal() : p.margin.vertical(); }
+
+	public:
+		virtual layout_size measure(layout_context& ctx, layout_size available) override
+		{
+			real pad_main = vertical() ? padding.vertical() : padding.horizontal();
+			real pad_cross = vertical() ? padding.horizontal() : padding.vertical();
+			real avail_cross = shrink(cross(available), pad_cross);
+			real sum{}, max_cross{};
+			for (size_t i = 0; i < ctx.count(); i++)
+			{
+				const auto& p = ctx.params(i);
+				real c = shrink(avail_cross, cross_margin(p));
+				auto s = ctx.measure(i, vertical() ? layout_size{ c, layout_size::unbounded } :
+					layout_size{ layout_size::unbounded, c });
+				sum += main(s) + main_margin(p);
+				max_cross = std::max(max_cross, cross(s) + cross_margin(p));
+			}
+			if (ctx.count())
+				sum += spacing * (ctx.count() - 1);
+			sum += pad_main;
+			max_cross += pad_cross;
+			return vertical() ? layout_size{ max_cross, sum } : layout_size{ sum, max_cross };
+		}
+		virtual void arrange(layout_context& ctx, layout_size size) override
+		{
+			real pad_main = vertical() ? padding.vertical() : padding.horizontal();
+			real pad_cross = vertical() ? padding.horizontal() : padding.vertical();
+			real cross_space = shrink(cross(size), pad_cross);
+			real used{}, total_grow{};
+			for (size_t i = 0; i < ctx.count(); i++)
+			{
+				const auto& p = ctx.params(i);
+				real c = shrink(cross_space, cross_margin(p));
+				used += main(ctx.measure(i, vertical() ? layout_size{ c, layout_size::unbounded } :
+					layout_size{ layout_size::unbounded, c })) + main_margin(p);
+				total_grow += std::max<real>(p.grow, 0);
+			}
+			if (ctx.count())
+				used += spacing * (ctx.count() - 1);
+			real extra = shrink(main(size), used + pad_main);
+
+			real pos = vertical() ? padding.top : padding.left;
+			real cross_start = vertical() ? padding.left : padding.top;
+			for (size_t i = 0; i < ctx.count(); i++)
+			{
+				const auto& p = ctx.params(i);
+				real c = shrink(cross_space, cross_margin(p));
+				auto desired = ctx.measure(i, vertical() ? layout_size{ c, layout_size::unbounded } :
+					layout_size{ layout_size::unbounded, c });
+				real length = main(desired);
+				if (total_grow > 0 && p.grow > 0)
+					length += extra * p.grow / total_grow;
+				if (vertical())
+				{
+					auto [x, w] = align(p.horizontal_align, cross_start + p.margin.left, c, desired.cx);
+					ctx.place(i, { x, pos + p.margin.top, w, length });
+				}
+				else
+				{
+					auto [y, h] = align(p.vertical_align, cross_start + p.margin.top, c, desired.cy);
+					ctx.place(i, { pos + p.margin.left, y, length, h });
+				}
+				pos += length + main_margin(p) + spacing;
+			}
+		}
+	};
+
+	/// <summary>
+	/// 网格的一行或一列：固定长度、按内容、或按权重分配剩余空间。
+	/// 按内容的轨道只考虑不跨轨道的子控件。
+	/// </summary>
+	struct grid_track
+	{
+		enum class kind : std::uint8_t
+		{
+			fixed,
+			content,
+			star,
+		};
+		kind type{ kind::star };
+		real value{ 1 };
+
+		static grid_track fixed(real length) { return { kind::fixed, length }; }
+		static grid_track content() { return { kind::content, 0 }; }
+		static grid_track star(real weight = 1) { return { kind::star, weight }; }
+	};
+
+	/// <summary>
+	/// 按行列放置子控件。子控件的 row、column 超出轨道数时放在最后一行或一列。
+	/// </summary>
+	class grid_layout : public layout
+	{
+	public:
+		std::vector<grid_track> rows{ grid_track::star() };
+		std::vector<grid_track> columns{ grid_track::star() };
+		real row_spacing{};
+		real column_spacing{};
+
+		grid_layout() = default;
+		grid_layout(std::vector<grid_track> rows, std::vector<grid_track> columns, real spacing = 0) :
+			rows(std::move(rows)), columns(std::move(columns)), row_spacing(spacing), column_spacing(spacing) {}
+
+	private:
+		/// <summary>
+		/// 一次测量或排列中的轨道长度。放在调用栈上，共享同一布局对象的组（包括嵌套的组）互不干扰。
+		/// </summary>
+		struct track_lengths
+		{
+			std::vector<real> rows;
+			std::vector<real> columns;
+		};
+
+		static size_t clamp_index(size_t i, size_t n) { return std::min(i, n ? n - 1 : 0); }
+		static size_t clamp_span(size_t start, size_t span, size_t n) { return std::max<size_t>(std::min(span, n - start), 1); }
+		/// <summary>
+		/// 计算轨道长度。available 为无穷时星形轨道按内容计算。
+		/// </summary>
+		track_lengths resolve_tracks(layout_context& ctx, layout_size available) const
+		{
+			track_lengths ret;
+			auto& row_lengths = ret.rows;
+			auto& column_lengths = ret.columns;
+			auto init = [](const std::vector<grid_track>& tracks, std::vector<real>& lengths)
+			{
+				lengths.assign(tracks.size(), 0);
+				for (size_t i = 0; i < tracks.size(); i++)
+					if (tracks[i].type == grid_track::kind::fixed)
+						lengths[i] = tracks[i].value;
+			};
+			init(rows, row_lengths);
+			init(columns, column_lengths);
+			bool fill_width = available.cx != layout_size::unbounded;
+			bool fill_height = available.cy != layout_size::unbounded;
+			auto sized_by_content = [](const grid_track& t, bool fill)
+			{
+				return t.type == grid_track::kind::content || (t.type == grid_track::kind::star && !fill);
+			};
+			for (size_t i = 0; i < ctx.count(); i++)
+			{
+				const auto& p = ctx.params(i);
+				size_t r = clamp_index(p.row, rows.size());
+				size_t c = clamp_index(p.column, columns.size());
+				bool size_row = clamp_span(r, p.row_span, rows.size()) == 1 && sized_by_content(rows[r], fill_height);
+				bool size_column = clamp_span(c, p.column_span, columns.size()) == 1 && sized_by_content(columns[c], fill_width);
+				if (!size_row && !size_column)
+					continue;
+				auto s = ctx.measure(i, { layout_size::unbounded, layout_size::unbounded });
+				if (size_row)
+					row_lengths[r] = std::max(row_lengths[r], s.cy + p.margin.vertical());
+				if (size_column)
+					column_lengths[c] = std::max(column_lengths[c], s.cx + p.margin.horizontal());
+			}
+			auto distribute = [](const std::vector<grid_track>& tracks, std::vector<real>& lengths, real available, real spacing)
+			{
+				if (available == layout_size::unbounded || tracks.empty())
+					return;
+				real used = spacing * (tracks.size() - 1), weight{};
+				for (size_t i = 0; i < tracks.size(); i++)
+					if (tracks[i].type == grid_track::kind::star)
+						weight += tracks[i].value;
+					else
+						used += lengths[i];
+				if (weight <= 0)
+					return;
+				real rest = shrink(available, used);
+				for (size_t i = 0; i < tracks.size(); i++)
+					if (tracks[i].type == grid_track::kind::star)
+						lengths[i] = rest * tracks[i].value / weight;
+			};
+			distribute(rows, row_lengths, available.cy, row_spacing);
+			distribute(columns, column_lengths, available.cx, column_spacing);
+			return ret;
+		}
+		/// <summary>
+		/// 把轨道长度换成各轨道的起点，末尾追加总长度加一个间距。
+		/// </summary>
+		static void to_offsets(std::vector<real>& lengths, real spacing)
+		{
+			real pos{};
+			for (auto& l : lengths)
+				pos += std::exchange(l, pos) + spacing;
+			lengths.push_back(pos);
+		}
+		static real span_length(const std::vector<real>& offsets, size_t index, size_t span, real spacing)
+		{
+			return offsets[index + span] - offsets[index] - spacing;
+		}
+
+	public:
+		virtual layout_size measure(layout_context& ctx, [[maybe_unused]] layout_size available) override
+		{
+			auto tracks = resolve_tracks(ctx, { layout_size::unbounded, layout_size::unbounded });
+			auto total = [](const std::vector<real>& lengths, real spacing)
+			{
+				real ret{};
+				for (auto l : lengths)
+					ret += l;
+				return lengths.empty() ? ret : ret + spacing * (lengths.size() - 1);
+			};
+			return { total(tracks.columns, column_spacing), total(tracks.rows, row_spacing) };
+		}
+		virtual void arrange(layout_context& ctx, layout_size size) override
+		{
+			if (rows.empty() || columns.empty())
+				return;
+			auto tracks = resolve_tracks(ctx, size);
+			auto& row_lengths = tracks.rows;
+			auto& column_lengths = tracks.columns;
+			to_offsets(row_lengths, row_spacing);
+			to_offsets(column_lengths, column_spacing);
+			for (size_t i = 0; i < ctx.count(); i++)
+			{
+				const auto& p = ctx.params(i);
+				size_t r = clamp_index(p.row, rows.size());
+				size_t c = clamp_index(p.column, columns.size());
+				place_in(ctx, i, column_lengths[c], row_lengths[r],
+					span_length(column_lengths, c, clamp_span(c, p.column_span, columns.size()), column_spacing),
+					span_length(row_lengths, r, clamp_span(r, p.row_span, rows.size()), row_spacing));
+			}
+		}
+	};
+
+	/// <summary>
+	/// 按到组边缘的距离放置。相对两边都设置时拉伸，只设置一边时按测量尺寸贴边，都不设置时按对齐放在整个组中。
+	/// </summary>
+	class anchor_layout : public layout
+	{
+		static std::pair<real, real> anchor(std::optional<real> near, std::optional<real> far,
+			layout_align a, real space, real desired, real margin_near, real margin_far)
+		{
+			if (near && far)
+				return { *near + margin_near, std::max<real>(space - *near - *far - margin_near - margin_far, 0) };
+			if (near)
+				return { *near + margin_near, desired };
+			if (far)
+				return { space - *far - margin_far - desired, desired };
+			return align(a, margin_near, space - margin_near - margin_far, desired);
+		}
+
+	public:
+		virtual layout_size measure(layout_context& ctx, layout_size available) override
+		{
+			layout_size ret;
+			for (size_t i = 0; i < ctx.count(); i++)
+			{
+				const auto& p = ctx.params(i);
+				auto s = ctx.measure(i, {
+					shrink(available.cx, p.left.value_or(0) + p.right.value_or(0) + p.margin.horizontal()),
+					shrink(available.cy, p.top.value_or(0) + p.bottom.value_or(0) + p.margin.vertical()) });
+				ret.cx = std::max(ret.cx, p.left.value_or(0) + s.cx + p.margin.horizontal() + p.right.value_or(0));
+				ret.cy = std::max(ret.cy, p.top.value_or(0) + s.cy + p.margin.vertical() + p.bottom.value_or(0));
+			}
+			return ret;
+		}
+		virtual void arrange(layout_context& ctx, layout_size size) override
+		{
+			for (size_t i = 0; i < ctx.count(); i++)
+			{
+				const auto& p = ctx.params(i);
+				auto s = ctx.measure(i, {
+					shrink(size.cx, p.left.value_or(0) + p.right.value_or(0) + p.margin.horizontal()),
+					shrink(size.cy, p.top.value_or(0) + p.bottom.value_or(0) + p.margin.vertical()) });
+				auto [x, cx] = anchor(p.left, p.right, p.horizontal_align, size.cx, s.cx, p.margin.left, p.margin.right);
+				auto [y, cy] = anchor(p.top, p.bottom, p.vertical_align, size.cy, s.cy, p.margin.top, p.margin.bottom);
+				ctx.place(i, { x, y, cx, cy });
+			}
+		}
+	};
+}
@@ -0,0 +1,223 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "direct_ui_types.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 预乘 alpha 的 RGBA8 颜色，在内存中按 R、G、B、A 排列，与软件后端的像素格式相同。
+	/// 大小为 color 的四分之一，适合大批量存放与混合。
+	/// </summary>
+	class packed_color
+	{
+	public:
+		std::uint32_t value{};
+
+	public:
+		constexpr packed_color() = default;
+		explicit constexpr packed_color(std::uint32_t value) : value(value) {}
+		/// <summary>
+		/// 分量截断到 [0, 1] 后预乘、四舍五入，因此各通道不超过 alpha。
+		/// </summary>
+		constexpr packed_color(const color& c)
+		{
+			auto to_byte = [](real v) -> std::uint32_t
+			{
+				return static_cast<std::uint32_t>(v * 255.f + 0.5f);
+			};
+			auto a = std::clamp(c.a, 0.f, 1.f);
+			value = to_byte(std::clamp(c.r, 0.f, 1.f) * a) | to_byte(std::clamp(c.g, 0.f, 1.f) * a) << 8 |
+				to_byte(std::clamp(c.b, 0.f, 1.f) * a) << 16 | to_byte(a) << 24;
+		}
+		/// <summary>
+		/// 还原为非预乘的颜色。全透明时 RGB 为零。
+		/// </summary>
+		constexpr color to_color() const
+		{
+			real a = static_cast<real>(alpha());
+			if (!a)
+				return { 0.f, 0.f, 0.f, 0.f };
+			return { static_cast<real>(value & 0xff) / a, static_cast<real>(value >> 8 & 0xff) / a,
+				static_cast<real>(value >> 16 & 0xff) / a, a / 255.f };
+		}
+		constexpr std::uint32_t alpha() const
+		{
+			return value >> 24;
+		}
+		constexpr bool operator==(const packed_color&) const = default;
+
+	public:
+		/// <summary>
+		/// 四个通道同时乘以 a / 255。
+		/// </summary>
+		static constexpr std::uint32_t scale(std::uint32_t p, std::uint32_t a)
+		{
+			std::uint32_t rb = (p & 0x00ff00ff) * a + 0x00800080;
+			rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+			std::uint32_t ag = ((p >> 8) & 0x00ff00ff) * a + 0x00800080;
+			ag = (ag + ((ag >> 8) & 0x00ff00ff)) & 0xff00ff00;
+			return rb | ag;
+		}
+		static constexpr std::uint32_t over(std::uint32_t dst, std::uint32_t src)
+		{
+			return src + scale(dst, 255 - (src >> 24));
+		}
+		/// <summary>
+		/// 按 weight / 256 在 a、b 间插值。
+		/// </summary>
+		static constexpr std::uint32_t lerp(std::uint32_t a, std::uint32_t b, std::uint32_t weight)
+		{
+			std::uint32_t rb = ((a & 0x00ff00ff) * (256 - weight) + (b & 0x00ff00ff) * weight) >> 8 & 0x00ff00ff;
+			std::uint32_t ag = ((a >> 8 & 0x00ff00ff) * (256 - weight) + (b >> 8 & 0x00ff00ff) * weight) & 0xff00ff00;
+			return rb | ag;
+		}
+		/// <summary>
+		/// 插值比例转为 lerp 使用的 [0, 256] 权重。
+		/// </summary>
+		static std::uint32_t to_weight(real ratio)
+		{
+			return static_cast<std::uint32_t>(std::clamp(ratio, 0.f, 1.f) * 256.f + 0.5f);
+		}
+	};
+	static_assert(sizeof(packed_color) == 4);
+
+	/// <summary>
+	/// 对 packed_color 数组的批量运算。有 SSE2 时每次处理四个颜色。
+	/// </summary>
+	namespace color_kernels
+	{
+		/// <summary>
+		/// 预乘并打包 n 个颜色，结果与逐个构造 packed_color 相同。
+		/// </summary>
+		inline void premultiply(const color* src, packed_color* dst, size_t n)
+		{
+			size_t i = 0;
+#if DIRECT_UI_SSE2
+			static_assert(sizeof(color) == 4 * sizeof(real));
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 max = _mm_set1_ps(255.f);
+			const __m128 half = _mm_set1_ps(0.5f);
+			// 用于把 alpha 通道的乘数换成 1。
+			const __m128 keep_alpha = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+			auto convert = [&](const color& c)
+			{
+				__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&c.r), zero), one);
+				__m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+				v = _mm_mul_ps(v, _mm_or_ps(_mm_andnot_ps(keep_alpha, a), _mm_and_ps(keep_alpha, one)));
+				return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, max), half));
+			};
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128i lo = _mm_packs_epi32(convert(src[i]), convert(src[i + 1]));
+				__m128i hi = _mm_packs_epi32(convert(src[i + 2]), convert(src[i + 3]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; i < n; i++)
+				dst[i] = packed_color(src[i]);
+		}
+		/// <summary>
+		/// 还原 n 个颜色。
+		/// </summary>
+		inline void unpremultiply(const packed_color* src, color* dst, size_t n)
+		{
+			for (size_t i = 0; i < n; i++)
+				dst[i] = src[i].to_color();
+		}
+		/// <summary>
+		/// dst[i] = a[i] 与 b[i] 按同一比例插值。
+		/// </summary>
+		inline void lerp(const packed_color* a, const packed_color* b, real ratio, packed_color* dst, size_t n)
+		{
+			std::uint32_t w = packed_color::to_weight(ratio);
+			size_t i = 0;
+#if DIRECT_UI_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i wb = _mm_set1_epi16(static_cast<short>(w));
+			const __m128i wa = _mm_set1_epi16(static_cast<short>(256 - w));
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+				__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+				__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+					_mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+				__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+					_mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+					_mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+			}
+#endif
+			for (; i < n; i++)
+				dst[i].value = packed_color::lerp(a[i].value, b[i].value, w);
+		}
+		/// <summary>
+		/// dst[i] = a[i] 与 b[i] 按各自的比例 ratio[i] 插值。
+		/// </summary>
+		inline void lerp(const packed_color* a, const packed_color* b, const real* ratio, packed_color* dst, size_t n)
+		{
+			size_t i = 0;
+#if DIRECT_UI_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 scale = _mm_set1_ps(256.f);
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128i full = _mm_set1_epi16(256);
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128 r = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(ratio + i), _mm_setzero_ps()), _mm_set1_ps(1.f));
+				__m128i w = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half));
+				// 每个权重扩展到对应颜色的四个 16 位通道。
+				w = _mm_packs_epi32(w, w);
+				w = _mm_unpacklo_epi16(w, w);
+				__m128i wlo = _mm_unpacklo_epi32(w, w);
+				__m128i whi = _mm_unpackhi_epi32(w, w);
+				__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+				__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+				__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), _mm_sub_epi16(full, wlo)),
+					_mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wlo));
+				__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), _mm_sub_epi16(full, whi)),
+					_mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), whi));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+					_mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+			}
+#endif
+			for (; i < n; i++)
+				dst[i].value = packed_color::lerp(a[i].value, b[i].value, packed_color::to_weight(ratio[i]));
+		}
+		/// <summary>
+		/// 将 src 以 source-over 混合到 dst 上。全透明的四颜色块直接跳过。
+		/// </summary>
+		inline void blend_over(packed_color* dst, const packed_color* src, size_t n)
+		{
+			size_t i = 0;
+#if DIRECT_UI_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i full = _mm_set1_epi16(255);
+			const __m128i bias = _mm_set1_epi16(128);
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF)
+					continue;
+				__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+				__m128i slo = _mm_unpacklo_epi8(s, zero);
+				__m128i shi = _mm_unpackhi_epi8(s, zero);
+				__m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+				__m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+				__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, alo)), bias);
+				__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, ahi)), bias);
+				lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+				hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi8(_mm_packus_epi16(lo, hi), s));
+			}
+#endif
+			for (; i < n; i++)
+				if (src[i].value)
+					dst[i].value = packed_color::over(dst[i].value, src[i].value);
+		}
+	}
+}
@@ -0,0 +1,114 @@
+﻿#pragma once
+
+#include <concepts>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 属性变化时需要失效的内容。
+	/// </summary>
+	enum class property_effect : std::uint8_t
+	{
+		none = 0,
+		paint = 1 << 0, // 重新录制所属控件的显示列表。
+		measure = 1 << 1, // 所属控件的自然尺寸可能改变。
+		update = 1 << 2, // 请求所属控件的 on_update。
+	};
+	constexpr property_effect operator|(property_effect a, property_effect b)
+	{
+		return static_cast<property_effect>(static_cast<std::uint8_t>(a) | static_cast<std::uint8_t>(b));
+	}
+	constexpr bool operator&(property_effect a, property_effect b)
+	{
+		return static_cast<std::uint8_t>(a) & static_cast<std::uint8_t>(b);
+	}
+
+	/// <summary>
+	/// 控件的可观察字段。值改变时只使所属控件的对应缓存失效：绘制失效沿祖先传播到已标记处即停止；
+	/// batched 时，同一帧内的多次测量失效合并为一次，在下一次更新开始时执行。
+	/// 所属对象由自身地址减去编译期已知的成员偏移得到，属性与 T 一样大，应以 DIRECT_UI_PROPERTY 声明。
+	/// 随所属对象复制构造时不通知；从另一个属性赋值只取其值，与 set 相同地通知。
+	/// </summary>
+	/// <typeparam name="T">值类型。可比较相等时，赋相同的值不通知。</typeparam>
+	/// <typeparam name="owner_t">直接声明该成员的类，需提供 invalidate_property(property_effect, bool)。</typeparam>
+	/// <typeparam name="offset">返回该成员在 owner_t 中的偏移。</typeparam>
+	template <typename T, typename owner_t, std::size_t (*offset)(), property_effect effects, bool batched = false>
+	class property
+	{
+		T _value;
+
+		owner_t& owner()
+		{
+			return *reinterpret_cast<owner_t*>(reinterpret_cast<std::byte*>(this) - offset());
+		}
+		void notify()
+		{
+			if constexpr (effects != property_effect::none)
+				owner().invalidate_property(effects, batched);
+		}
+
+	public:
+		property(T value = {}) : _value(std::move(value)) {}
+		property(const property&) = default;
+		/// <summary>
+		/// 控件之间传递属性值，如 a.caption = b.caption，应使 a 失效。
+		/// </summary>
+		property& operator=(const property& another)
+		{
+			set(another._value);
+			return *this;
+		}
+		property& operator=(T value)
+		{
+			set(std::move(value));
+			return *this;
+		}
+
+	public:
+		const T& get() const { return _value; }
+		operator const T&() const { return _value; }
+		const T* operator->() const { return &_value; }
+		void set(T value)
+		{
+			if constexpr (std::equality_comparable<T>)
+				if (_value == value)
+					return;
+			_value = std::move(value);
+			notify();
+		}
+		/// <summary>
+		/// 就地修改，之后总是通知。适用于容器等不便整体赋值的类型。
+		/// </summary>
+		template <typename modifier_t>
+		void modify(modifier_t&& modifier)
+			requires std::invocable<modifier_t, T&>
+		{
+			modifier(_value);
+			notify();
+		}
+	};
+}
+
+// 控件带有虚基类，不是标准布局类型，offsetof 对其直接成员仍然有效，只需关闭 GCC 的提示。
+#if defined(__GNUC__)
+#define DIRECT_UI_OFFSETOF_BEGIN _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Winvalid-offsetof\"")
+#define DIRECT_UI_OFFSETOF_END _Pragma("GCC diagnostic pop")
+#else
+#define DIRECT_UI_OFFSETOF_BEGIN
+#define DIRECT_UI_OFFSETOF_END
+#endif
+/// <summary>
+/// 在 owner_t 的定义中声明属性 name，其后可以接初始值，如 DIRECT_UI_PROPERTY(logic_rect, real, pen_size, property_effect::paint){ 1 };
+/// 最后的参数依次为失效方式与是否合并。T 中含有逗号时先以 using 起别名。
+/// </summary>
+#define DIRECT_UI_PROPERTY(owner_t, T, name, ...) \
+	static std::size_t name##_offset() \
+	{ \
+		DIRECT_UI_OFFSETOF_BEGIN \
+		return offsetof(owner_t, name); \
+		DIRECT_UI_OFFSETOF_END \
+	} \
+	::direct_ui::property<T, owner_t, &owner_t::name##_offset, __VA_ARGS__> name
@@ -0,0 +1,161 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "direct_ui.hpp"
+
+namespace direct_ui
+{
+	struct reconcile_statistics
+	{
+		size_t reused{};
+		size_t created{};
+		size_t destroyed{};
+		size_t moved{}; // 复用的控件中改变了相对顺序的个数。
+	};
+
+	/// <summary>
+	/// 按键对齐子控件时，为新出现的键创建控件，并把控件绑定到键上。
+	/// </summary>
+	template <typename key_t>
+	class keyed_children_source
+	{
+	public:
+		virtual ~keyed_children_source() {}
+
+	public:
+		virtual std::shared_ptr<dep_widget_base> create(const key_t& key) = 0;
+		/// <summary>
+		/// 每次对齐后，对目标列表中的每个控件调用，index 为它的新位置。复用的控件同样会被调用。
+		/// </summary>
+		virtual void bind(dep_widget_base& widget, const key_t& key, size_t index) {}
+		/// <summary>
+		/// 键从目标列表中消失时调用。此时控件已移出组，但尚未释放。
+		/// </summary>
+		virtual void destroy(dep_widget_base& widget, const key_t& key) {}
+	};
+
+	/// <summary>
+	/// 求序列的一个最长严格递增子序列，返回各元素是否属于它。O(n log n)。
+	/// </summary>
+	inline std::vector<bool> longest_increasing_subsequence(std::span<const size_t> values)
+	{
+		std::vector<size_t> tails; // tails[k] 为长度 k + 1 的递增子序列中结尾最小者的下标。
+		std::vector<size_t> previous(values.size(), SIZE_MAX);
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			auto it = std::lower_bound(tails.begin(), tails.end(), values[i],
+				[&](size_t j, size_t value) { return values[j] < value; });
+			if (it != tails.begin())
+				previous[i] = *(it - 1);
+			if (it == tails.end())
+				tails.push_back(i);
+			else
+				*it = i;
+		}
+		std::vector<bool> ret(values.size());
+		for (size_t i = tails.empty() ? SIZE_MAX : tails.back(); i != SIZE_MAX; i = previous[i])
+			ret[i] = true;
+		return ret;
+	}
+
+	/// <summary>
+	/// 用稳定的键描述组的子控件。每次给出目标键列表，与上次的结果比较：键相同的控件原样复用，
+	/// 只为新增的键创建控件、移出消失的键。复用的控件中，旧位置构成最长递增子序列的视为不动，
+	/// 只有其余的控件计为移动并重绘；顺序与成员都不变时不重建子控件数组。组的子控件应只由同一个 keyed_children 修改。
+	/// </summary>
+	template <typename key_t, typename hash_t = std::hash<key_t>, typename equal_t = std::equal_to<key_t>>
+	class keyed_children
+	{
+		std::vector<key_t> _keys; // 与组的 widgets 一一对应。
+		std::unordered_map<key_t, size_t, hash_t, equal_t> index;
+
+	public:
+		/// <summary>
+		/// 使 group 的子控件与 keys 一一对应。keys 中不能有重复的键。
+		/// 创建控件时抛出异常则组与已有的控件保持不变。
+		/// </summary>
+		reconcile_statistics reconcile(logic_group& group, std::span<const key_t> keys, keyed_children_source<key_t>& source)
+		{
+			if (group.widgets.size() != _keys.size())
+				throw std::runtime_error("Fail to reconcile children modified elsewhere.");
+			reconcile_statistics stats;
+			constexpr size_t none = SIZE_MAX;
+			std::vector<size_t> sources(keys.size(), none); // 每个目标位置对应的旧位置。
+			std::vector<size_t> reused_sources;
+			std::vector<bool> kept(_keys.size());
+			std::unordered_map<key_t, size_t, hash_t, equal_t> next_index;
+			next_index.reserve(keys.size());
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				if (!next_index.emplace(keys[i], i).second)
+					throw std::runtime_error("Fail to reconcile duplicate keys.");
+				auto it = index.find(keys[i]);
+				if (it == index.end())
+					continue;
+				kept[it->second] = true;
+				sources[i] = it->second;
+				reused_sources.push_back(it->second);
+			}
+			auto stable = longest_increasing_subsequence(reused_sources);
+			stats.reused = reused_sources.size();
+			stats.moved = std::count(stable.begin(), stable.end(), false);
+			stats.created = keys.size() - stats.reused;
+			stats.destroyed = _keys.size() - stats.reused;
+			bool changed = stats.created || stats.destroyed || stats.moved;
+
+			// 先建好新的子控件数组再换入，create 抛出异常时组不受影响。
+			std::vector<std::shared_ptr<dep_widget_base>> removed;
+			if (changed)
+			{
+				std::vector<std::shared_ptr<dep_widget_base>> widgets;
+				widgets.reserve(keys.size());
+				for (size_t i = 0; i < keys.size(); i++)
+					widgets.push_back(sources[i] != none ? group.widgets[sources[i]] : source.create(keys[i]));
+				std::vector<key_t> removed_keys;
+				removed.reserve(stats.destroyed);
+				removed_keys.reserve(stats.destroyed);
+				for (size_t i = 0; i < _keys.size(); i++)
+					if (!kept[i])
+					{
+						removed.push_back(std::move(group.widgets[i]));
+						removed_keys.push_back(std::move(_keys[i]));
+					}
+				group.widgets.swap(widgets);
+				_keys.assign(keys.begin(), keys.end());
+				index = std::move(next_index);
+				for (size_t i = 0; i < removed.size(); i++)
+					source.destroy(*removed[i], removed_keys[i]);
+			}
+
+			for (size_t i = 0, reused = 0; i < keys.size(); i++)
+			{
+				source.bind(*group.widgets[i], keys[i], i);
+				// 只有移动的控件需要重绘；新建的控件本来就是脏的，不动的控件保留绘制结果。
+				if (sources[i] != none && !stable[reused++])
+					to_logic_ref(group.widgets[i])->invalidate();
+			}
+			if (changed)
+				group.invalidate_layout();
+			return stats;
+		}
+		const std::vector<key_t>& keys() const
+		{
+			return _keys;
+		}
+		/// <summary>
+		/// 键对应的子控件在组中的位置。不存在时返回 SIZE_MAX。
+		/// </summary>
+		size_t find(const key_t& key) const
+		{
+			auto it = index.find(key);
+			return it == index.end() ? SIZE_MAX : it->second;
+		}
+	};
+}
@@ -0,0 +1,131 @@
+﻿#pragma once
+
+#include <vector>
+#include <string_view>
+#include <span>
+
+#include "direct_ui_types.hpp"
+#include "display_list.hpp"
+#include "resource_cache.hpp"
+#include "text_layout.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 渲染后端接口。坐标以 DIP 为单位，后端自行处理 DPI 缩放。
+	/// </summary>
+	class render_backend
+	{
+	public:
+		static constexpr int default_dpi = 96;
+	public:
+		virtual ~render_backend() {}
+
+	public:
+		virtual void resize(int width, int height, int dpi) = 0;
+		virtual void begin_draw() = 0;
+		virtual void end_draw() = 0;
+		virtual void clear(const color& c) = 0;
+
+	public:
+		virtual void set_transform(const matrix& m) = 0;
+		virtual void push_clip(real left, real top, real right, real bottom) = 0;
+		virtual void pop_clip() = 0;
+		virtual void fill_rect(real left, real top, real right, real bottom, const color& brush) = 0;
+		virtual void draw_rect(real left, real top, real right, real bottom, const color& brush, real stroke) = 0;
+		virtual void fill_ellipse(real x, real y, real rx, real ry, const color& brush) = 0;
+		/// <summary>
+		/// 一次绘制一批实心圆。默认逐个调用 fill_ellipse。
+		/// </summary>
+		virtual void fill_circles(std::span<const circle_instance> circles)
+		{
+			for (const auto& c : circles)
+				fill_ellipse(c.x, c.y, c.r, c.r, c.brush.to_color());
+		}
+		virtual void draw_text(std::wstring_view str, const text_format& format,
+			real left, real top, real right, real bottom, const color& brush) = 0;
+		/// <summary>
+		/// 只排版不绘制，返回文字在给定排版框内的尺寸。与 draw_text 共用排版缓存。
+		/// </summary>
+		virtual text_metrics measure_text(std::wstring_view str, const text_format& format,
+			real max_width, real max_height) = 0;
+
+	public:
+		virtual void begin_layer(unsigned layer, real width, real height) = 0;
+		virtual void end_layer() = 0;
+		virtual void draw_layer(unsigned layer, real width, real height) = 0;
+		virtual void release_layer(unsigned layer) = 0;
+
+	public:
+		/// <summary>
+		/// 后端绘制资源缓存的命中统计。
+		/// </summary>
+		virtual cache_statistics resource_statistics() const
+		{
+			return {};
+		}
+
+	private:
+		std::vector<matrix> transforms;
+	public:
+		/// <summary>
+		/// 回放显示列表。变换栈在这里维护，后端只需要接受最终变换。
+		/// </summary>
+		void replay(const display_list& dl)
+		{
+			using enum display_list::command_type;
+			transforms.assign(1, matrix::identity());
+			set_transform(transforms.back());
+			for (const auto& c : dl.commands())
+			{
+				switch (c.type)
+				{
+				case fill_rect:
+					this->fill_rect(c.v[0], c.v[1], c.v[2], c.v[3], c.brush);
+					break;
+				case draw_rect:
+					this->draw_rect(c.v[0], c.v[1], c.v[2], c.v[3], c.brush, c.v[4]);
+					break;
+				case fill_ellipse:
+					this->fill_ellipse(c.v[0], c.v[1], c.v[2], c.v[3], c.brush);
+					break;
+				case fill_circles:
+					this->fill_circles(dl.circles(c));
+					break;
+				case draw_text:
+					this->draw_text(dl.text(c),
+						{ dl.family(c), c.v[4], c.weight, c.align, c.paragraph_align },
+						c.v[0], c.v[1], c.v[2], c.v[3], c.brush);
+					break;
+				case push_clip:
+					this->push_clip(c.v[0], c.v[1], c.v[2], c.v[3]);
+					break;
+				case pop_clip:
+					this->pop_clip();
+					break;
+				case push_transform:
+					transforms.push_back(display_list::to_matrix(c) * transforms.back());
+					set_transform(transforms.back());
+					break;
+				case pop_transform:
+					transforms.pop_back();
+					set_transform(transforms.back());
+					break;
+				case begin_layer:
+					this->begin_layer(c.text, c.v[0], c.v[1]);
+					transforms.push_back(matrix::identity());
+					set_transform(transforms.back());
+					break;
+				case end_layer:
+					this->end_layer();
+					transforms.pop_back();
+					set_transform(transforms.back());
+					break;
+				case draw_layer:
+					this->draw_layer(c.text, c.v[0], c.v[1]);
+					break;
+				}
+			}
+		}
+	};
+}
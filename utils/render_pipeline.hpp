@@ -0,0 +1,137 @@
+﻿#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+
+#include "display_list.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 交给渲染线程的一帧。生成后不再修改，渲染线程只读取它，不访问控件。
+	/// </summary>
+	struct render_snapshot
+	{
+		struct resize_request
+		{
+			int width;
+			int height;
+			int dpi;
+		};
+		display_list frame;
+		std::optional<resize_request> resize; // 在重放之前应用到后端。
+		std::vector<unsigned> released_layers;
+
+		void clear()
+		{
+			frame.clear();
+			resize.reset();
+			released_layers.clear();
+		}
+	};
+
+	/// <summary>
+	/// 双缓冲的渲染线程。生成线程写入一个缓冲区时，渲染线程重放另一个。
+	/// 层缓存依赖之前的帧，快照不能丢弃，因此渲染落后一整帧时 publish 会等待。
+	/// </summary>
+	class render_pipeline
+	{
+		render_snapshot buffers[2];
+		size_t write_index{};
+		std::optional<size_t> ready; // 已发布、等待渲染的缓冲区。
+		bool rendering{};
+		bool exit{};
+		size_t _produced{};
+		size_t _rendered{};
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::function<void(render_snapshot&)> render;
+		std::thread render_thread;
+
+		void render_routine()
+		{
+			while (true)
+			{
+				size_t index;
+				{
+					std::unique_lock<std::mutex> lck(mutex);
+					cv.wait(lck, [&] { return exit || ready; });
+					if (!ready)
+						return;
+					index = *ready;
+					ready.reset();
+					rendering = true;
+				}
+				render(buffers[index]);
+				{
+					std::lock_guard<std::mutex> lck(mutex);
+					rendering = false;
+					_rendered++;
+				}
+				cv.notify_all();
+			}
+		}
+
+	public:
+		explicit render_pipeline(std::function<void(render_snapshot&)> render) :
+			render(std::move(render)),
+			render_thread(&render_pipeline::render_routine, this) {}
+		render_pipeline(const render_pipeline&) = delete;
+		render_pipeline(render_pipeline&&) = delete;
+		render_pipeline& operator=(const render_pipeline&) = delete;
+		render_pipeline& operator=(render_pipeline&&) = delete;
+		/// <summary>
+		/// 渲染完已发布的帧后退出。
+		/// </summary>
+		~render_pipeline()
+		{
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				exit = true;
+			}
+			cv.notify_all();
+			render_thread.join();
+		}
+
+	public:
+		/// <summary>
+		/// 生成线程写入的缓冲区，内容为上上一帧，使用前应先清空。
+		/// </summary>
+		render_snapshot& back()
+		{
+			return buffers[write_index];
+		}
+		/// <summary>
+		/// 发布 back()，换到另一个缓冲区。另一个缓冲区尚未渲染完时等待。
+		/// </summary>
+		void publish()
+		{
+			std::unique_lock<std::mutex> lck(mutex);
+			cv.wait(lck, [&] { return !ready && !rendering; });
+			ready = write_index;
+			write_index ^= 1;
+			_produced++;
+			lck.unlock();
+			cv.notify_all();
+		}
+		/// <summary>
+		/// 等待已发布的帧全部渲染完成。
+		/// </summary>
+		void wait_idle()
+		{
+			std::unique_lock<std::mutex> lck(mutex);
+			cv.wait(lck, [&] { return !ready && !rendering; });
+		}
+		size_t produced() const { return _produced; }
+		size_t rendered()
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			return _rendered;
+		}
+	};
+}
@@ -0,0 +1,197 @@
+﻿#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <utility>
+
+#include "direct_ui_types.hpp"
+#include "display_list.hpp"
+
+namespace direct_ui
+{
+	struct cache_statistics
+	{
+		size_t hits{};
+		size_t misses{};
+		size_t evictions{};
+		size_t entries{};
+		size_t bytes{};
+	};
+
+	/// <summary>
+	/// 带 LRU 淘汰的绘制资源缓存。返回的句柄带引用计数，被淘汰的资源在最后一个句柄释放后才销毁。
+	/// 内部加锁，可以被多个场景共享。除条目数上限外，还可以按资源估计的字节数设置预算。
+	/// </summary>
+	/// <typeparam name="key_t">键类型。</typeparam>
+	/// <typeparam name="value_t">资源类型。</typeparam>
+	/// <typeparam name="hash_t">哈希。若带 is_transparent，可用其他类型查找。</typeparam>
+	/// <typeparam name="equal_t">相等比较。若带 is_transparent，可用其他类型查找。</typeparam>
+	template <typename key_t, typename value_t,
+		typename hash_t = std::hash<key_t>, typename equal_t = std::equal_to<key_t>>
+	class resource_cache
+	{
+	public:
+		using handle = std::shared_ptr<value_t>;
+	private:
+		struct entry
+		{
+			key_t key;
+			handle value;
+			size_t bytes;
+		};
+		std::list<entry> entries;
+		std::unordered_map<key_t, typename std::list<entry>::iterator, hash_t, equal_t> index;
+		size_t _capacity;
+		size_t _budget;
+		size_t _bytes{};
+		cache_statistics stats;
+		mutable std::mutex mutex;
+
+	public:
+		resource_cache(size_t capacity, size_t budget = SIZE_MAX) :
+			_capacity(capacity ? capacity : 1), _budget(budget) {}
+		resource_cache(const resource_cache&) = delete;
+		resource_cache(resource_cache&&) = delete;
+		resource_cache& operator=(const resource_cache&) = delete;
+		resource_cache& operator=(resource_cache&&) = delete;
+
+	public:
+		/// <summary>
+		/// 取得资源。未命中时调用 create 创建，create 返回空句柄时不缓存。
+		/// </summary>
+		template <typename lookup_t, typename create_t>
+		handle get(const lookup_t& key, create_t&& create)
+		{
+			return get(key, std::forward<create_t>(create), [](const value_t&) { return size_t{}; });
+		}
+		/// <summary>
+		/// 取得资源。bytes_of 估计新资源占用的字节数，计入预算。
+		/// </summary>
+		template <typename lookup_t, typename create_t, typename bytes_t>
+		handle get(const lookup_t& key, create_t&& create, bytes_t&& bytes_of)
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			auto it = index.find(key);
+			if (it != index.end())
+			{
+				stats.hits++;
+				entries.splice(entries.begin(), entries, it->second);
+				return it->second->value;
+			}
+			stats.misses++;
+			handle ret = create();
+			if (!ret)
+				return ret;
+			size_t bytes = bytes_of(*ret);
+			entries.push_front({ key_t(key), ret, bytes });
+			index.emplace(entries.front().key, entries.begin());
+			_bytes += bytes;
+			while (entries.size() > _capacity || (_bytes > _budget && entries.size() > 1))
+			{
+				_bytes -= entries.back().bytes;
+				index.erase(entries.back().key);
+				entries.pop_back();
+				stats.evictions++;
+			}
+			return ret;
+		}
+		void clear()
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			index.clear();
+			entries.clear();
+			_bytes = 0;
+		}
+		size_t capacity() const
+		{
+			return _capacity;
+		}
+		size_t budget() const
+		{
+			return _budget;
+		}
+		cache_statistics statistics() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			auto ret = stats;
+			ret.entries = entries.size();
+			ret.bytes = _bytes;
+			return ret;
+		}
+		void reset_statistics()
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			stats = {};
+		}
+	};
+
+	/// <summary>
+	/// 持有字体名的文字格式键。可以直接用 text_format 查找。
+	/// </summary>
+	struct text_format_key
+	{
+		std::wstring family;
+		real size{};
+		unsigned short weight{};
+		text_align align{};
+		text_align paragraph_align{};
+
+		text_format_key(const text_format& format) :
+			family(format.family), size(format.size), weight(format.weight),
+			align(format.align), paragraph_align(format.paragraph_align) {}
+		operator text_format() const
+		{
+			return { family, size, weight, align, paragraph_align };
+		}
+	};
+	struct text_format_hash
+	{
+		using is_transparent = void;
+		size_t operator()(const text_format& f) const
+		{
+			size_t h = std::hash<std::wstring_view>()(f.family);
+			h ^= std::hash<real>()(f.size) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			h ^= (static_cast<size_t>(f.weight) << 16 |
+				static_cast<size_t>(f.align) << 8 |
+				static_cast<size_t>(f.paragraph_align)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			return h;
+		}
+		size_t operator()(const text_format_key& k) const
+		{
+			return (*this)(static_cast<text_format>(k));
+		}
+	};
+	struct text_format_equal
+	{
+		using is_transparent = void;
+		static bool equal(const text_format& a, const text_format& b)
+		{
+			return a.family == b.family && a.size == b.size && a.weight == b.weight &&
+				a.align == b.align && a.paragraph_align == b.paragraph_align;
+		}
+		template <typename a_t, typename b_t>
+		bool operator()(const a_t& a, const b_t& b) const
+		{
+			return equal(static_cast<text_format>(a), static_cast<text_format>(b));
+		}
+	};
+
+	/// <summary>
+	/// 将颜色量化为 8 位 ARGB，作为画刷缓存的键。
+	/// </summary>
+	inline std::uint32_t color_key(const color& c)
+	{
+		auto to_byte = [](real v) -> std::uint32_t
+		{
+			return static_cast<std::uint32_t>((v < 0 ? 0 : v > 1 ? 1 : v) * 255.f + 0.5f);
+		};
+		return to_byte(c.a) << color::alpha_shift | to_byte(c.r) << color::red_shift |
+			to_byte(c.g) << color::green_shift | to_byte(c.b) << color::blue_shift;
+	}
+}
@@ -0,0 +1,722 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <span>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <optional>
+#include <tuple>
+#include <cstring>
+#include <cstdint>
+
+#if _MSVC_LANG
+#include <Windows.h>
+#undef min
+#undef max
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "direct_ui.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 场景描述中的属性键。custom 及之后的键由控件类型自行解释。
+	/// </summary>
+	enum class scene_key : std::uint16_t
+	{
+		visible,
+		focusable,
+		cached_layer,
+		independent_children,
+		layout, // 整数，见 scene_layout_kind。
+		layout_spacing,
+		layout_padding,
+		grid_row_fixed, // 每个键追加一条轨道。
+		grid_row_content,
+		grid_row_star,
+		grid_column_fixed,
+		grid_column_content,
+		grid_column_star,
+		fixed_cx, // 以下为 layout_params 的字段。
+		fixed_cy,
+		margin,
+		horizontal_align,
+		vertical_align,
+		grow,
+		row,
+		column,
+		row_span,
+		column_span,
+		left,
+		top,
+		right,
+		bottom,
+		text, // 按钮的标题。
+		brush_color, // 矩形。
+		pen_color,
+		pen_size,
+		custom = 0x100,
+	};
+	enum class scene_layout_kind : std::int32_t
+	{
+		none,
+		anchor,
+		vertical_stack,
+		horizontal_stack,
+		grid,
+	};
+
+	/// <summary>
+	/// 二进制场景描述的内存布局。所有数组 8 字节对齐，按本机字节序存放，直接以指针访问。
+	/// 节点按广度优先排列：父节点在子节点之前，同一父节点的子节点连续。
+	/// </summary>
+	struct scene_blob_header
+	{
+		static constexpr std::uint32_t magic_value = 'D' | 'U' << 8 | 'I' << 16 | 'S' << 24;
+		static constexpr std::uint32_t current_version = 1;
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t type_count, node_count, property_count, string_count, char_count;
+		std::uint32_t types_offset, nodes_offset, properties_offset, strings_offset, chars_offset;
+	};
+	struct scene_blob_string
+	{
+		std::uint32_t offset;
+		std::uint32_t length;
+	};
+	struct scene_blob_node
+	{
+		static constexpr std::uint32_t none = UINT32_MAX;
+		std::uint32_t type; // 类型名表的下标。
+		std::uint32_t parent;
+		std::uint32_t name; // 字符串表的下标，未命名为 none。
+		std::uint32_t first_child;
+		std::uint32_t child_count;
+		std::uint32_t first_property;
+		std::uint32_t property_count;
+		real x, y, cx, cy;
+	};
+	struct scene_blob_property
+	{
+		enum class kind : std::uint16_t
+		{
+			boolean,
+			integer,
+			number,
+			color,
+			string, // 字符串表的下标。
+			node, // 节点下标。
+		};
+		scene_key key;
+		kind type;
+		union
+		{
+			std::int32_t i;
+			real f;
+			std::uint32_t u;
+		};
+
+		bool as_bool() const { return i != 0; }
+		std::int32_t as_int() const { return i; }
+		real as_real() const { return type == kind::number ? f : static_cast<real>(i); }
+		direct_ui::color as_color() const { return direct_ui::color(u); }
+	};
+	static_assert(sizeof(scene_blob_property) == 8);
+
+	/// <summary>
+	/// 只读的二进制场景描述。载入时只检查各数组的范围，不逐字段解析。
+	/// </summary>
+	class scene_blob
+	{
+		// 文件的只读映射，或按 8 字节对齐的缓冲区。删除器负责解除映射或释放缓冲区。
+		std::shared_ptr<const std::uint8_t> storage;
+		const scene_blob_header* header{};
+
+		template <typename T>
+		const T* array(std::uint32_t offset) const
+		{
+			return reinterpret_cast<const T*>(storage.get() + offset);
+		}
+		void validate(size_t size)
+		{
+			if (size < sizeof(scene_blob_header))
+				throw std::runtime_error("Invalid scene blob.");
+			header = reinterpret_cast<const scene_blob_header*>(storage.get());
+			if (header->magic != scene_blob_header::magic_value || header->version != scene_blob_header::current_version)
+				throw std::runtime_error("Invalid scene blob.");
+			auto check = [&](std::uint32_t offset, std::uint32_t count, size_t element)
+			{
+				if (offset % 8 || offset > size || count > (size - offset) / element)
+					throw std::runtime_error("Invalid scene blob.");
+			};
+			check(header->types_offset, header->type_count, sizeof(std::uint32_t));
+			check(header->nodes_offset, header->node_count, sizeof(scene_blob_node));
+			check(header->properties_offset, header->property_count, sizeof(scene_blob_property));
+			check(header->strings_offset, header->string_count, sizeof(scene_blob_string));
+			check(header->chars_offset, header->char_count, 1);
+			for (const auto& s : strings())
+				if (s.offset > header->char_count || s.length > header->char_count - s.offset)
+					throw std::runtime_error("Invalid scene blob.");
+			for (auto t : types())
+				if (t >= header->string_count)
+					throw std::runtime_error("Invalid scene blob.");
+			auto all = nodes();
+			for (std::uint32_t i = 0; i < all.size(); i++)
+			{
+				const auto& n = all[i];
+				// 父节点必须排在前面，且本节点落在父节点的子节点范围内。
+				if (n.type >= header->type_count ||
+					n.first_property > header->property_count || n.property_count > header->property_count - n.first_property ||
+					n.first_child > header->node_count || n.child_count > header->node_count - n.first_child ||
+					(n.parent != scene_blob_node::none && (n.parent >= i ||
+						i < all[n.parent].first_child || i - all[n.parent].first_child >= all[n.parent].child_count)) ||
+					(n.name != scene_blob_node::none && n.name >= header->string_count))
+					throw std::runtime_error("Invalid scene blob.");
+			}
+			auto props = std::span<const scene_blob_property>(array<scene_blob_property>(header->properties_offset), header->property_count);
+			for (const auto& p : props)
+				if ((p.type == scene_blob_property::kind::string && p.u >= header->string_count) ||
+					(p.type == scene_blob_property::kind::node && p.u >= header->node_count))
+					throw std::runtime_error("Invalid scene blob.");
+		}
+
+		scene_blob() = default;
+
+	public:
+		scene_blob(const scene_blob&) = delete;
+		scene_blob(scene_blob&&) = default;
+		scene_blob& operator=(const scene_blob&) = delete;
+		scene_blob& operator=(scene_blob&&) = default;
+		explicit scene_blob(const std::vector<std::uint8_t>& bytes)
+		{
+			auto buffer = std::make_shared<std::uint64_t[]>((bytes.size() + 7) / 8);
+			std::memcpy(buffer.get(), bytes.data(), bytes.size());
+			storage = std::shared_ptr<const std::uint8_t>(buffer, reinterpret_cast<const std::uint8_t*>(buffer.get()));
+			validate(bytes.size());
+		}
+		/// <summary>
+		/// 将文件只读映射到内存，数组直接指向映射的页面，不做逐字段的解析或拷贝。
+		/// 映射在最后一个 scene_blob 释放时解除，期间不应修改文件。
+		/// </summary>
+		static scene_blob load(const std::string& path)
+		{
+			scene_blob ret;
+			size_t size{};
+#if _MSVC_LANG
+			HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				throw std::runtime_error("Fail to open scene blob.");
+			LARGE_INTEGER file_size{};
+			if (!GetFileSizeEx(file, &file_size))
+			{
+				CloseHandle(file);
+				throw std::runtime_error("Fail to GetFileSizeEx.");
+			}
+			size = static_cast<size_t>(file_size.QuadPart);
+			if (size < sizeof(scene_blob_header))
+			{
+				CloseHandle(file);
+				throw std::runtime_error("Invalid scene blob.");
+			}
+			HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (!mapping)
+				throw std::runtime_error("Fail to CreateFileMapping.");
+			auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+			if (!view)
+				throw std::runtime_error("Fail to MapViewOfFile.");
+			ret.storage.reset(static_cast<const std::uint8_t*>(view), [](const std::uint8_t* p) { UnmapViewOfFile(p); });
+#else
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw std::runtime_error("Fail to open scene blob.");
+			struct stat st {};
+			if (::fstat(fd, &st) != 0)
+			{
+				::close(fd);
+				throw std::runtime_error("Fail to stat scene blob.");
+			}
+			size = static_cast<size_t>(st.st_size);
+			if (size < sizeof(scene_blob_header))
+			{
+				::close(fd);
+				throw std::runtime_error("Invalid scene blob.");
+			}
+			auto view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (view == MAP_FAILED)
+				throw std::runtime_error("Fail to mmap scene blob.");
+			ret.storage.reset(static_cast<const std::uint8_t*>(view), [size](const std::uint8_t* p)
+				{
+					::munmap(const_cast<std::uint8_t*>(p), size);
+				});
+#endif
+			ret.validate(size);
+			return ret;
+		}
+
+	public:
+		std::span<const std::uint32_t> types() const
+		{
+			return { array<std::uint32_t>(header->types_offset), header->type_count };
+		}
+		std::span<const scene_blob_node> nodes() const
+		{
+			return { array<scene_blob_node>(header->nodes_offset), header->node_count };
+		}
+		std::span<const scene_blob_property> properties(const scene_blob_node& n) const
+		{
+			return { array<scene_blob_property>(header->properties_offset) + n.first_property, n.property_count };
+		}
+		std::span<const scene_blob_string> strings() const
+		{
+			return { array<scene_blob_string>(header->strings_offset), header->string_count };
+		}
+		std::string_view string(std::uint32_t index) const
+		{
+			if (index >= header->string_count)
+				throw std::runtime_error("Invalid scene blob string index.");
+			const auto& s = strings()[index];
+			return { array<char>(header->chars_offset) + s.offset, s.length };
+		}
+		std::u8string_view u8string(std::uint32_t index) const
+		{
+			auto s = string(index);
+			return { reinterpret_cast<const char8_t*>(s.data()), s.size() };
+		}
+	};
+
+	/// <summary>
+	/// 构造二进制场景描述。节点可按任意顺序添加，build 时重排为广度优先。
+	/// </summary>
+	class scene_blob_builder
+	{
+	public:
+		using node = std::uint32_t;
+		struct node_ref
+		{
+			node target;
+		};
+	private:
+		struct pending_node
+		{
+			std::uint32_t type;
+			node parent;
+			std::uint32_t name{ scene_blob_node::none };
+			real x, y, cx, cy;
+			std::vector<node> children;
+			std::vector<scene_blob_property> properties;
+		};
+		std::vector<pending_node> nodes;
+		std::vector<std::string> string_table;
+		std::unordered_map<std::string, std::uint32_t> string_index;
+		std::vector<std::uint32_t> type_table;
+		std::unordered_map<std::uint32_t, std::uint32_t> type_index;
+
+		std::uint32_t intern(std::string_view str)
+		{
+			auto [it, inserted] = string_index.try_emplace(std::string(str), static_cast<std::uint32_t>(string_table.size()));
+			if (inserted)
+				string_table.emplace_back(str);
+			return it->second;
+		}
+		void push(node n, scene_key key, scene_blob_property::kind kind, std::uint32_t bits)
+		{
+			scene_blob_property p{ key, kind, { .u = bits } };
+			nodes.at(n).properties.push_back(p);
+		}
+
+	public:
+		/// <summary>
+		/// 添加节点。type 为注册表中的类型名；parent 为空时节点挂在实例化时给定的组下。
+		/// </summary>
+		node add(std::string_view type, std::optional<node> parent = {},
+			real x = 0, real y = 0, real cx = 0, real cy = 0)
+		{
+			auto name = intern(type);
+			auto [it, inserted] = type_index.try_emplace(name, static_cast<std::uint32_t>(type_table.size()));
+			if (inserted)
+				type_table.push_back(name);
+			node ret = static_cast<node>(nodes.size());
+			nodes.push_back({ it->second, parent ? *parent : scene_blob_node::none, scene_blob_node::none, x, y, cx, cy, {}, {} });
+			if (parent)
+				nodes.at(*parent).children.push_back(ret);
+			return ret;
+		}
+		/// <summary>
+		/// 命名节点，实例化后可以按名字找到对应的控件。
+		/// </summary>
+		void name(node n, std::string_view name)
+		{
+			nodes.at(n).name = intern(name);
+		}
+		void set(node n, scene_key key, bool value) { push(n, key, scene_blob_property::kind::boolean, value); }
+		void set(node n, scene_key key, int value) { push(n, key, scene_blob_property::kind::integer, static_cast<std::uint32_t>(value)); }
+		void set(node n, scene_key key, real value)
+		{
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			push(n, key, scene_blob_property::kind::number, bits);
+		}
+		void set(node n, scene_key key, const color& value) { push(n, key, scene_blob_property::kind::color, color_key(value)); }
+		void set(node n, scene_key key, std::u8string_view value)
+		{
+			push(n, key, scene_blob_property::kind::string,
+				intern({ reinterpret_cast<const char*>(value.data()), value.size() }));
+		}
+		void set(node n, scene_key key, node_ref value) { push(n, key, scene_blob_property::kind::node, value.target); }
+		/// <summary>
+		/// 设置布局参数，只写入与默认值不同的字段。margin 只支持四边相同。
+		/// </summary>
+		void set(node n, const layout_params& p)
+		{
+			if (p.cx) set(n, scene_key::fixed_cx, *p.cx);
+			if (p.cy) set(n, scene_key::fixed_cy, *p.cy);
+			if (p.margin.left || p.margin.top || p.margin.right || p.margin.bottom) set(n, scene_key::margin, p.margin.left);
+			if (p.horizontal_align != layout_align{}) set(n, scene_key::horizontal_align, static_cast<int>(p.horizontal_align));
+			if (p.vertical_align != layout_align{}) set(n, scene_key::vertical_align, static_cast<int>(p.vertical_align));
+			if (p.grow) set(n, scene_key::grow, p.grow);
+			if (p.row) set(n, scene_key::row, static_cast<int>(p.row));
+			if (p.column) set(n, scene_key::column, static_cast<int>(p.column));
+			if (p.row_span != 1) set(n, scene_key::row_span, static_cast<int>(p.row_span));
+			if (p.column_span != 1) set(n, scene_key::column_span, static_cast<int>(p.column_span));
+			if (p.left) set(n, scene_key::left, *p.left);
+			if (p.top) set(n, scene_key::top, *p.top);
+			if (p.right) set(n, scene_key::right, *p.right);
+			if (p.bottom) set(n, scene_key::bottom, *p.bottom);
+		}
+
+	public:
+		std::vector<std::uint8_t> build() const
+		{
+			// 广度优先编号。
+			std::vector<node> order;
+			std::vector<std::uint32_t> new_index(nodes.size(), scene_blob_node::none);
+			order.reserve(nodes.size());
+			for (node i = 0; i < nodes.size(); i++)
+				if (nodes[i].parent == scene_blob_node::none)
+					order.push_back(i);
+			for (size_t i = 0; i < order.size(); i++)
+				for (auto child : nodes[order[i]].children)
+					order.push_back(child);
+			for (size_t i = 0; i < order.size(); i++)
+				new_index[order[i]] = static_cast<std::uint32_t>(i);
+
+			std::vector<scene_blob_node> flat;
+			std::vector<scene_blob_property> properties;
+			flat.reserve(order.size());
+			for (auto i : order)
+			{
+				const auto& n = nodes[i];
+				scene_blob_node out{ n.type, n.parent == scene_blob_node::none ? scene_blob_node::none : new_index[n.parent],
+					n.name, n.children.empty() ? 0 : new_index[n.children.front()],
+					static_cast<std::uint32_t>(n.children.size()),
+					static_cast<std::uint32_t>(properties.size()), static_cast<std::uint32_t>(n.properties.size()),
+					n.x, n.y, n.cx, n.cy };
+				flat.push_back(out);
+				for (auto p : n.properties)
+				{
+					if (p.type == scene_blob_property::kind::node)
+						p.u = new_index.at(p.u);
+					properties.push_back(p);
+				}
+			}
+			std::vector<scene_blob_string> strings;
+			std::string chars;
+			for (const auto& s : string_table)
+			{
+				strings.push_back({ static_cast<std::uint32_t>(chars.size()), static_cast<std::uint32_t>(s.size()) });
+				chars += s;
+			}
+
+			std::vector<std::uint8_t> ret(sizeof(scene_blob_header));
+			auto append = [&](const void* data, size_t bytes)
+			{
+				ret.resize((ret.size() + 7) / 8 * 8);
+				auto offset = static_cast<std::uint32_t>(ret.size());
+				ret.insert(ret.end(), static_cast<const std::uint8_t*>(data), static_cast<const std::uint8_t*>(data) + bytes);
+				return offset;
+			};
+			scene_blob_header h{ scene_blob_header::magic_value, scene_blob_header::current_version,
+				static_cast<std::uint32_t>(type_table.size()), static_cast<std::uint32_t>(flat.size()),
+				static_cast<std::uint32_t>(properties.size()), static_cast<std::uint32_t>(strings.size()),
+				static_cast<std::uint32_t>(chars.size()), 0, 0, 0, 0, 0 };
+			h.types_offset = append(type_table.data(), type_table.size() * sizeof(type_table[0]));
+			h.nodes_offset = append(flat.data(), flat.size() * sizeof(flat[0]));
+			h.properties_offset = append(properties.data(), properties.size() * sizeof(properties[0]));
+			h.strings_offset = append(strings.data(), strings.size() * sizeof(strings[0]));
+			h.chars_offset = append(chars.data(), chars.size());
+			std::memcpy(ret.data(), &h, sizeof(h));
+			return ret;
+		}
+		void save(const std::string& path) const
+		{
+			auto bytes = build();
+			std::ofstream fs(path, std::ios::binary);
+			if (!fs)
+				throw std::runtime_error("Fail to open scene blob for writing.");
+			fs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		}
+	};
+
+	/// <summary>
+	/// 可以用 std::string_view 查找 std::string 键的哈希。
+	/// </summary>
+	struct scene_name_hash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view name) const
+		{
+			return std::hash<std::string_view>()(name);
+		}
+	};
+
+	/// <summary>
+	/// 实例化的结果。只保存有名字的节点，其余节点由控件树持有。名字复制保存，场景描述可以在实例化后释放。
+	/// </summary>
+	struct scene_instance
+	{
+		std::unordered_map<std::string, std::shared_ptr<dep_widget_base>, scene_name_hash, std::equal_to<>> names;
+
+		template <typename dep_widget_t = dep_widget_base>
+		std::shared_ptr<dep_widget_t> find(std::string_view name) const
+		{
+			auto it = names.find(name);
+			if (it == names.end())
+				return {};
+			return std::dynamic_pointer_cast<dep_widget_t>(it->second);
+		}
+	};
+
+	/// <summary>
+	/// 类型名到控件构造与属性解释的映射。内置 group、rect、button。
+	/// </summary>
+	class scene_type_registry
+	{
+	public:
+		/// <summary>
+		/// 新建的控件及其静态转换得到的各层指针，实例化时不再做 dynamic_cast。
+		/// typed 指向注册时的控件类型，只交给同一条目的 apply。
+		/// </summary>
+		struct built
+		{
+			std::shared_ptr<dep_widget_base> widget;
+			logic_widget* logic;
+			logic_group* group;
+			void* typed;
+		};
+		/// <summary>
+		/// 按节点下标排列的控件，供 apply 解释节点引用。不持有引用。
+		/// </summary>
+		using node_table = std::span<dep_widget_base* const>;
+		using build_function = built(*)(scene&);
+		using apply_function = std::function<void(void*, const scene_blob_property&, const scene_blob&, node_table)>;
+		struct entry
+		{
+			build_function build;
+			apply_function apply;
+		};
+	private:
+		std::unordered_map<std::string, entry, scene_name_hash, std::equal_to<>> types;
+
+	public:
+		scene_type_registry()
+		{
+			add<group>("group");
+			add<rect>("rect", [](rect& r, const scene_blob_property& p, const scene_blob&, node_table)
+				{
+					if (p.key == scene_key::brush_color)
+						r.brush_color = p.as_color();
+					else if (p.key == scene_key::pen_color)
+						r.pen_color = p.as_color();
+					else if (p.key == scene_key::pen_size)
+						r.pen_size = p.as_real();
+				});
+			add<button>("button", [](button& b, const scene_blob_property& p, const scene_blob& blob, node_table)
+				{
+					if (p.key == scene_key::text && p.type == scene_blob_property::kind::string)
+						b.caption = std::u8string(blob.u8string(p.u));
+				});
+		}
+		/// <summary>
+		/// 注册类型。apply 只会收到通用键以外的属性，节点引用属性在所有节点创建之后才会收到。
+		/// </summary>
+		template <typename dep_widget_t, typename apply_t = std::nullptr_t>
+		void add(std::string name, apply_t apply = nullptr)
+		{
+			entry e;
+			e.build = [](scene& s) -> built
+			{
+				auto w = s.build_dep_widget<dep_widget_t>();
+				dep_widget_t* typed = w.get();
+				logic_group* group{};
+				if constexpr (std::is_base_of_v<logic_group, dep_widget_t>)
+					group = typed;
+				return { std::move(w), typed, group, typed };
+			};
+			if constexpr (!std::is_same_v<apply_t, std::nullptr_t>)
+				e.apply = [apply](void* w, const scene_blob_property& p, const scene_blob& blob, node_table nodes)
+				{
+					apply(*static_cast<dep_widget_t*>(w), p, blob, nodes);
+				};
+			types[std::move(name)] = std::move(e);
+		}
+		const entry* find(std::string_view name) const
+		{
+			auto it = types.find(name);
+			return it == types.end() ? nullptr : &it->second;
+		}
+	};
+
+	namespace scene_blob_detail
+	{
+		/// <summary>
+		/// 解释通用键。返回 false 表示交给类型自己处理。
+		/// </summary>
+		inline bool apply_common(logic_widget& w, logic_group* g, const scene_blob_property& p,
+			layout_params& params, bool& has_params, std::shared_ptr<layout>& engine)
+		{
+			auto stack = [&]() -> stack_layout* { return dynamic_cast<stack_layout*>(engine.get()); };
+			auto grid = [&]() -> grid_layout* { return dynamic_cast<grid_layout*>(engine.get()); };
+			auto param = [&](auto& field, auto value) { field = value; has_params = true; };
+			switch (p.key)
+			{
+			case scene_key::visible: w.set_visible(p.as_bool()); return true;
+			case scene_key::focusable: w.set_focusable(p.as_bool()); return true;
+			case scene_key::cached_layer: if (g) g->cached_layer = p.as_bool(); return true;
+			case scene_key::independent_children: if (g) g->set_independent_children(p.as_bool()); return true;
+			case scene_key::layout:
+				switch (static_cast<scene_layout_kind>(p.as_int()))
+				{
+				case scene_layout_kind::anchor: engine = std::make_shared<anchor_layout>(); break;
+				case scene_layout_kind::vertical_stack: engine = std::make_shared<stack_layout>(stack_layout::orientation::vertical); break;
+				case scene_layout_kind::horizontal_stack: engine = std::make_shared<stack_layout>(stack_layout::orientation::horizontal); break;
+				case scene_layout_kind::grid:
+				{
+					auto l = std::make_shared<grid_layout>();
+					l->rows.clear();
+					l->columns.clear();
+					engine = l;
+					break;
+				}
+				default: engine.reset(); break;
+				}
+				return true;
+			case scene_key::layout_spacing:
+				if (auto s = stack()) s->spacing = p.as_real();
+				if (auto l = grid()) l->row_spacing = l->column_spacing = p.as_real();
+				return true;
+			case scene_key::layout_padding:
+				if (auto s = stack()) s->padding = { p.as_real(), p.as_real(), p.as_real(), p.as_real() };
+				return true;
+			case scene_key::grid_row_fixed: if (auto l = grid()) l->rows.push_back(grid_track::fixed(p.as_real())); return true;
+			case scene_key::grid_row_content: if (auto l = grid()) l->rows.push_back(grid_track::content()); return true;
+			case scene_key::grid_row_star: if (auto l = grid()) l->rows.push_back(grid_track::star(p.as_real())); return true;
+			case scene_key::grid_column_fixed: if (auto l = grid()) l->columns.push_back(grid_track::fixed(p.as_real())); return true;
+			case scene_key::grid_column_content: if (auto l = grid()) l->columns.push_back(grid_track::content()); return true;
+			case scene_key::grid_column_star: if (auto l = grid()) l->columns.push_back(grid_track::star(p.as_real())); return true;
+			case scene_key::fixed_cx: param(params.cx, p.as_real()); return true;
+			case scene_key::fixed_cy: param(params.cy, p.as_real()); return true;
+			case scene_key::margin: param(params.margin, layout_thickness{ p.as_real(), p.as_real(), p.as_real(), p.as_real() }); return true;
+			case scene_key::horizontal_align: param(params.horizontal_align, static_cast<layout_align>(p.as_int())); return true;
+			case scene_key::vertical_align: param(params.vertical_align, static_cast<layout_align>(p.as_int())); return true;
+			case scene_key::grow: param(params.grow, p.as_real()); return true;
+			case scene_key::row: param(params.row, static_cast<unsigned short>(p.as_int())); return true;
+			case scene_key::column: param(params.column, static_cast<unsigned short>(p.as_int())); return true;
+			case scene_key::row_span: param(params.row_span, static_cast<unsigned short>(p.as_int())); return true;
+			case scene_key::column_span: param(params.column_span, static_cast<unsigned short>(p.as_int())); return true;
+			case scene_key::left: param(params.left, p.as_real()); return true;
+			case scene_key::top: param(params.top, p.as_real()); return true;
+			case scene_key::right: param(params.right, p.as_real()); return true;
+			case scene_key::bottom: param(params.bottom, p.as_real()); return true;
+			default: return false;
+			}
+		}
+	}
+
+	/// <summary>
+	/// 按场景描述创建控件，顶层节点挂到 parent 下。按节点数组一遍完成创建、设置属性与挂接，
+	/// 每个控件只访问一次；引用其他节点的属性推迟到最后应用。类型名在开始时逐类型解析一次。
+	/// 未注册的类型抛出 std::runtime_error。
+	/// </summary>
+	inline scene_instance instantiate(scene& s, logic_group& parent, const scene_blob& blob,
+		const scene_type_registry& registry = {})
+	{
+		std::vector<const scene_type_registry::entry*> types;
+		types.reserve(blob.types().size());
+		for (auto t : blob.types())
+		{
+			auto e = registry.find(blob.string(t));
+			if (!e)
+				throw std::runtime_error("Unknown widget type in scene blob.");
+			types.push_back(e);
+		}
+
+		scene_instance ret;
+		auto nodes = blob.nodes();
+		// 组供后面的子节点挂接，validate 保证父节点在前。
+		std::vector<dep_widget_base*> widgets(nodes.size());
+		std::vector<logic_group*> groups(nodes.size());
+		std::vector<std::tuple<const scene_type_registry::entry*, void*, const scene_blob_property*>> deferred;
+		parent.widgets.reserve(parent.widgets.size() + std::count_if(nodes.begin(), nodes.end(),
+			[](const scene_blob_node& n) { return n.parent == scene_blob_node::none; }));
+		for (std::uint32_t i = 0; i < nodes.size(); i++)
+		{
+			const auto& n = nodes[i];
+			const auto& type = *types[n.type];
+			auto b = type.build(s);
+			b.logic->move(n.x, n.y);
+			b.logic->resize(n.cx, n.cy);
+			if (n.child_count)
+			{
+				if (!b.group)
+					throw std::runtime_error("Scene blob node with children is not a group.");
+				b.group->widgets.reserve(n.child_count);
+				groups[i] = b.group;
+			}
+			if (n.property_count)
+			{
+				layout_params params;
+				bool has_params{};
+				std::shared_ptr<layout> engine;
+				bool has_engine{};
+				for (const auto& p : blob.properties(n))
+				{
+					if (p.type == scene_blob_property::kind::node)
+						deferred.emplace_back(&type, b.typed, &p);
+					else if (!scene_blob_detail::apply_common(*b.logic, b.group, p, params, has_params, engine) && type.apply)
+						type.apply(b.typed, p, blob, {});
+					has_engine |= p.key == scene_key::layout;
+				}
+				if (has_params)
+					b.logic->set_layout_params(params);
+				if (has_engine && b.group)
+					b.group->set_layout(std::move(engine));
+			}
+			widgets[i] = b.widget.get();
+			auto& owner = n.parent == scene_blob_node::none ? parent : *groups[n.parent];
+			if (n.name != scene_blob_node::none)
+				ret.names.emplace(blob.string(n.name), b.widget);
+			owner.widgets.push_back(std::move(b.widget));
+		}
+		for (auto [type, typed, p] : deferred)
+			if (type->apply)
+				type->apply(typed, *p, blob, widgets);
+		parent.invalidate_layout();
+		return ret;
+	}
+}
@@ -0,0 +1,612 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <string_view>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include "render_backend.hpp"
+#include "glyph_atlas.hpp"
+#include "packed_color.hpp"
+
+namespace direct_ui
+{
+	namespace soft_raster
+	{
+		/// <summary>
+		/// 像素格式为预乘 alpha 的 RGBA8，与 packed_color 相同。
+		/// </summary>
+		inline std::uint32_t premultiply(const color& c)
+		{
+			return packed_color(c).value;
+		}
+		inline std::uint32_t scale(std::uint32_t p, std::uint32_t a)
+		{
+			return packed_color::scale(p, a);
+		}
+		inline std::uint32_t over(std::uint32_t dst, std::uint32_t src)
+		{
+			return packed_color::over(dst, src);
+		}
+		inline std::uint32_t to_coverage(real c)
+		{
+			return static_cast<std::uint32_t>(std::clamp(c, 0.f, 1.f) * 255.f + 0.5f);
+		}
+		/// <summary>
+		/// 以纯色对一段像素做 source-over 混合。
+		/// </summary>
+		inline void blend_span(std::uint32_t* dst, size_t n, std::uint32_t src)
+		{
+			std::uint32_t a = src >> 24;
+			if (!a)
+				return;
+			if (a == 255)
+			{
+				std::fill_n(dst, n, src);
+				return;
+			}
+			size_t i = 0;
+#if DIRECT_UI_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i inv = _mm_set1_epi16(static_cast<short>(255 - a));
+			const __m128i bias = _mm_set1_epi16(128);
+			const __m128i s = _mm_set1_epi32(static_cast<int>(src));
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+				__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), bias);
+				__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), bias);
+				lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+				hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+				d = _mm_add_epi8(_mm_packus_epi16(lo, hi), s);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), d);
+			}
+#endif
+			for (; i < n; i++)
+				dst[i] = over(dst[i], src);
+		}
+		/// <summary>
+		/// 以纯色和逐像素覆盖率对一段像素做 source-over 混合。覆盖率全为零的四像素块直接跳过。
+		/// </summary>
+		inline void blend_mask_span(std::uint32_t* dst, const unsigned char* mask, size_t n, std::uint32_t src)
+		{
+			size_t i = 0;
+#if DIRECT_UI_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i full = _mm_set1_epi16(255);
+			const __m128i bias = _mm_set1_epi16(128);
+			const __m128i s16 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(src)), zero);
+			for (; i + 4 <= n; i += 4)
+			{
+				std::uint32_t m4;
+				std::memcpy(&m4, mask + i, 4);
+				if (!m4)
+					continue;
+				// 每个覆盖率扩展到对应像素的四个 16 位通道。
+				__m128i m = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(m4)), zero);
+				m = _mm_unpacklo_epi16(m, m);
+				__m128i mlo = _mm_unpacklo_epi32(m, m);
+				__m128i mhi = _mm_unpackhi_epi32(m, m);
+				__m128i slo = _mm_add_epi16(_mm_mullo_epi16(s16, mlo), bias);
+				__m128i shi = _mm_add_epi16(_mm_mullo_epi16(s16, mhi), bias);
+				slo = _mm_srli_epi16(_mm_add_epi16(slo, _mm_srli_epi16(slo, 8)), 8);
+				shi = _mm_srli_epi16(_mm_add_epi16(shi, _mm_srli_epi16(shi, 8)), 8);
+				__m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+				__m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+				__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+				__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, alo)), bias);
+				__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, ahi)), bias);
+				lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+				hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+					_mm_add_epi8(_mm_packus_epi16(lo, hi), _mm_packus_epi16(slo, shi)));
+			}
+#endif
+			for (; i < n; i++)
+				if (mask[i])
+					dst[i] = over(dst[i], mask[i] == 255 ? src : scale(src, mask[i]));
+		}
+		/// <summary>
+		/// 将一段预乘像素以 source-over 混合到目标上。
+		/// </summary>
+		inline void blend_over_span(std::uint32_t* dst, const std::uint32_t* src, size_t n)
+		{
+			color_kernels::blend_over(reinterpret_cast<packed_color*>(dst), reinterpret_cast<const packed_color*>(src), n);
+		}
+	}
+
+	/// <summary>
+	/// CPU 软件光栅化后端，渲染到内存中的 RGBA8 缓冲。
+	/// 矩形与椭圆使用解析覆盖率抗锯齿；裁剪区域为对齐到像素的轴对齐矩形。
+	/// 文字只做单行排版，不随变换旋转，字形经图集缓存。离屏层按整像素平移合成，其余变换使用最近邻采样。
+	/// </summary>
+	class soft_backend : public render_backend
+	{
+		struct clip_rect
+		{
+			int left;
+			int top;
+			int right;
+			int bottom;
+		};
+		struct surface
+		{
+			int width{};
+			int height{};
+			std::vector<std::uint32_t> pixels;
+		};
+
+		surface screen;
+		surface* target{ &screen };
+		std::unordered_map<unsigned, surface> layers;
+		std::vector<std::pair<surface*, size_t>> targets;
+		matrix base;
+		matrix transform;
+		std::vector<clip_rect> clips;
+		std::shared_ptr<glyph_source> glyphs;
+		glyph_atlas atlas;
+
+	public:
+		/// <summary>
+		/// 排好的一行文字。坐标以设备像素为单位，相对排版框左上角，y 为基线。
+		/// </summary>
+		struct shaped_text
+		{
+			struct glyph
+			{
+				char32_t code_point;
+				real x;
+				real y;
+			};
+			std::vector<glyph> glyphs;
+			text_metrics metrics;
+		};
+	private:
+		text_layout_cache<shaped_text> layouts{ 1024, 1 << 20 };
+
+	public:
+		soft_backend(std::shared_ptr<glyph_source> glyphs = std::make_shared<box_glyph_source>()) :
+			glyphs(std::move(glyphs))
+		{
+			clips.push_back({});
+		}
+
+	public:
+		int width() const { return screen.width; }
+		int height() const { return screen.height; }
+		const std::vector<std::uint32_t>& pixels() const { return screen.pixels; }
+		std::uint32_t pixel(int x, int y) const
+		{
+			return screen.pixels[static_cast<size_t>(y) * screen.width + x];
+		}
+		size_t layer_count() const { return layers.size(); }
+
+	public:
+		virtual void resize(int width, int height, int dpi) override
+		{
+			screen.width = std::max(0, width);
+			screen.height = std::max(0, height);
+			screen.pixels.assign(static_cast<size_t>(screen.width) * screen.height, 0);
+			real s = static_cast<real>(dpi) / default_dpi;
+			base = matrix::scale(s, s);
+			clips.assign(1, { 0, 0, screen.width, screen.height });
+			layers.clear();
+		}
+		virtual void begin_draw() override
+		{
+			target = &screen;
+			targets.clear();
+			clips.assign(1, { 0, 0, screen.width, screen.height });
+			transform = base;
+		}
+		virtual void end_draw() override
+		{
+		}
+		virtual void clear(const color& c) override
+		{
+			const auto& clip = clips.back();
+			auto src = soft_raster::premultiply(c);
+			for (int y = clip.top; y < clip.bottom; y++)
+				std::fill_n(row(y) + clip.left, clip.right - clip.left, src);
+		}
+
+	public:
+		virtual void set_transform(const matrix& m) override
+		{
+			transform = m * base;
+		}
+		virtual void push_clip(real left, real top, real right, real bottom) override
+		{
+			auto [x0, y0, x1, y1] = device_bounds(left, top, right, bottom);
+			const auto& cur = clips.back();
+			clip_rect next{
+				std::max(cur.left, static_cast<int>(std::lround(x0))),
+				std::max(cur.top, static_cast<int>(std::lround(y0))),
+				std::min(cur.right, static_cast<int>(std::lround(x1))),
+				std::min(cur.bottom, static_cast<int>(std::lround(y1))) };
+			next.right = std::max(next.left, next.right);
+			next.bottom = std::max(next.top, next.bottom);
+			clips.push_back(next);
+		}
+		virtual void pop_clip() override
+		{
+			if (clips.size() > 1)
+				clips.pop_back();
+		}
+		virtual void fill_rect(real left, real top, real right, real bottom, const color& brush) override
+		{
+			auto src = soft_raster::premultiply(brush);
+			if (!(src >> 24))
+				return;
+			if (transform.is_axis_aligned())
+			{
+				auto [x0, y0, x1, y1] = device_bounds(left, top, right, bottom);
+				fill_device_rect(x0, y0, x1, y1, src);
+			}
+			else
+				fill_general(left, top, right, bottom, src, [=](real x, real y)
+					{
+						return std::max(std::max(left - x, x - right), std::max(top - y, y - bottom));
+					});
+		}
+		virtual void draw_rect(real left, real top, real right, real bottom, const color& brush, real stroke) override
+		{
+			real h = stroke / 2;
+			fill_rect(left - h, top - h, right + h, top + h, brush);
+			fill_rect(left - h, bottom - h, right + h, bottom + h, brush);
+			fill_rect(left - h, top + h, left + h, bottom - h, brush);
+			fill_rect(right - h, top + h, right + h, bottom - h, brush);
+		}
+		virtual void fill_ellipse(real x, real y, real rx, real ry, const color& brush) override
+		{
+			fill_ellipse(x, y, rx, ry, soft_raster::premultiply(brush));
+		}
+		virtual void fill_circles(std::span<const circle_instance> circles) override
+		{
+			for (const auto& c : circles)
+				fill_ellipse(c.x, c.y, c.r, c.r, c.brush.value);
+		}
+		virtual void draw_text(std::wstring_view str, const text_format& format,
+			real left, real top, real right, real bottom, const color& brush) override
+		{
+			auto src = soft_raster::premultiply(brush);
+			if (!(src >> 24) || str.empty())
+				return;
+			real s = std::sqrt(std::abs(transform.determinant()));
+			if (format.size * s <= 0)
+				return;
+
+			auto layout = shape(str, format, s, (right - left) * s, (bottom - top) * s);
+			real px = format.size * s;
+			real origin_x = transform.transform_x(left, top);
+			real origin_y = transform.transform_y(left, top);
+			for (const auto& g : layout->glyphs)
+			{
+				auto q = static_cast<int>(std::floor((origin_x + g.x) * glyph_atlas::subpixel_steps + 0.5f));
+				int x = q >= 0 ? q / glyph_atlas::subpixel_steps : -((-q + glyph_atlas::subpixel_steps - 1) / glyph_atlas::subpixel_steps);
+				auto m = atlas.get(*glyphs, g.code_point, format.family, format.weight, px,
+					q - x * glyph_atlas::subpixel_steps);
+				blit_mask(m.coverage, m.width, m.height, m.stride,
+					x + m.left, static_cast<int>(std::lround(origin_y + g.y)) - m.top, src);
+			}
+		}
+		virtual text_metrics measure_text(std::wstring_view str, const text_format& format,
+			real max_width, real max_height) override
+		{
+			if (format.size <= 0)
+				return {};
+			return shape(str, format, 1, max_width, max_height)->metrics;
+		}
+
+	public:
+		virtual cache_statistics resource_statistics() const override
+		{
+			auto l = layouts.statistics();
+			auto g = atlas.statistics();
+			return { l.hits + g.hits, l.misses + g.misses, l.evictions + g.evictions,
+				l.entries + g.entries, l.bytes + g.bytes };
+		}
+		cache_statistics text_layout_statistics() const
+		{
+			return layouts.statistics();
+		}
+		const glyph_atlas& glyph_cache() const
+		{
+			return atlas;
+		}
+
+	public:
+		virtual void begin_layer(unsigned layer, real width, real height) override
+		{
+			auto& l = layers[layer];
+			int w = std::max(0, static_cast<int>(std::ceil(width * base.m11)));
+			int h = std::max(0, static_cast<int>(std::ceil(height * base.m22)));
+			if (l.width != w || l.height != h)
+			{
+				l.width = w;
+				l.height = h;
+				l.pixels.assign(static_cast<size_t>(w) * h, 0);
+			}
+			else
+				std::fill(l.pixels.begin(), l.pixels.end(), 0);
+			targets.push_back({ target, clips.size() });
+			target = &l;
+			clips.push_back({ 0, 0, w, h });
+		}
+		virtual void end_layer() override
+		{
+			if (targets.empty())
+				return;
+			target = targets.back().first;
+			clips.resize(targets.back().second);
+			targets.pop_back();
+		}
+		virtual void draw_layer(unsigned layer, real width, real height) override
+		{
+			auto it = layers.find(layer);
+			if (it == layers.end() || &it->second == target)
+				return;
+			const auto& l = it->second;
+			const auto& clip = clips.back();
+			auto m = matrix::scale(1 / base.m11, 1 / base.m22) * transform;
+			if (m.is_axis_aligned() && std::abs(m.m11 - 1) < 1e-4f && std::abs(m.m22 - 1) < 1e-4f)
+			{
+				int ox = static_cast<int>(std::lround(m.dx));
+				int oy = static_cast<int>(std::lround(m.dy));
+				int x0 = std::max(clip.left, ox);
+				int x1 = std::min(clip.right, ox + l.width);
+				int y0 = std::max(clip.top, oy);
+				int y1 = std::min(clip.bottom, oy + l.height);
+				if (x0 >= x1)
+					return;
+				for (int y = y0; y < y1; y++)
+					soft_raster::blend_over_span(row(y) + x0,
+						l.pixels.data() + static_cast<size_t>(y - oy) * l.width + (x0 - ox), x1 - x0);
+				return;
+			}
+			auto inv = m.inverse();
+			auto [bx0, by0, bx1, by1] = device_bounds(0, 0, width, height);
+			int x0 = std::max(clip.left, static_cast<int>(std::floor(bx0)));
+			int y0 = std::max(clip.top, static_cast<int>(std::floor(by0)));
+			int x1 = std::min(clip.right, static_cast<int>(std::ceil(bx1)));
+			int y1 = std::min(clip.bottom, static_cast<int>(std::ceil(by1)));
+			for (int y = y0; y < y1; y++)
+			{
+				auto p = row(y);
+				for (int x = x0; x < x1; x++)
+				{
+					real px = x + 0.5f, py = y + 0.5f;
+					int u = static_cast<int>(std::floor(inv.transform_x(px, py)));
+					int v = static_cast<int>(std::floor(inv.transform_y(px, py)));
+					if (0 <= u && u < l.width && 0 <= v && v < l.height)
+						p[x] = soft_raster::over(p[x], l.pixels[static_cast<size_t>(v) * l.width + u]);
+				}
+			}
+		}
+		virtual void release_layer(unsigned layer) override
+		{
+			auto it = layers.find(layer);
+			if (it != layers.end() && &it->second != target)
+				layers.erase(it);
+		}
+
+	private:
+		std::uint32_t* row(int y)
+		{
+			return target->pixels.data() + static_cast<size_t>(y) * target->width;
+		}
+		std::tuple<real, real, real, real> device_bounds(real left, real top, real right, real bottom) const
+		{
+			real xs[4]{
+				transform.transform_x(left, top), transform.transform_x(right, top),
+				transform.transform_x(left, bottom), transform.transform_x(right, bottom) };
+			real ys[4]{
+				transform.transform_y(left, top), transform.transform_y(right, top),
+				transform.transform_y(left, bottom), transform.transform_y(right, bottom) };
+			return {
+				*std::min_element(xs, xs + 4), *std::min_element(ys, ys + 4),
+				*std::max_element(xs, xs + 4), *std::max_element(ys, ys + 4) };
+		}
+		static real ellipse_distance(real dx, real dy, real rx, real ry)
+		{
+			real nx = dx / rx;
+			real ny = dy / ry;
+			real f = nx * nx + ny * ny - 1;
+			real g = 2 * std::sqrt(nx * nx / (rx * rx) + ny * ny / (ry * ry));
+			return g > 0 ? f / g : -std::min(rx, ry);
+		}
+		/// <summary>
+		/// 按 scale 倍字号排版，width、height 为设备像素下的排版框。结果进入排版缓存。
+		/// </summary>
+		text_layout_cache<shaped_text>::handle shape(std::wstring_view str, const text_format& format,
+			real scale, real width, real height)
+		{
+			text_format scaled = format;
+			scaled.size = format.size * scale;
+			return layouts.get(text_layout_view(str, scaled, width, height), [&]
+				{
+					auto ret = std::make_shared<shaped_text>();
+					real px = scaled.size;
+					std::u32string code_points;
+					decode(str, code_points);
+					ret->glyphs.reserve(code_points.size());
+					real pen = 0;
+					for (auto cp : code_points)
+					{
+						ret->glyphs.push_back({ cp, pen, 0 });
+						pen += glyphs->advance(cp, format.family, format.weight, px);
+					}
+					auto fm = glyphs->metrics(format.family, px);
+					real line = fm.ascent + fm.descent;
+
+					real x = 0;
+					if (format.align == text_align::center)
+						x = width / 2 - pen / 2;
+					else if (format.align == text_align::trailing)
+						x = width - pen;
+					real y = 0;
+					if (format.paragraph_align == text_align::center)
+						y = height / 2 - line / 2;
+					else if (format.paragraph_align == text_align::trailing)
+						y = height - line;
+					y += fm.ascent;
+					for (auto& g : ret->glyphs)
+					{
+						g.x += x;
+						g.y = y;
+					}
+					ret->metrics = { pen / scale, line / scale, fm.ascent / scale };
+					return ret;
+				}, [&](const shaped_text& t)
+				{
+					return sizeof(shaped_text) + str.length() * sizeof(wchar_t) +
+						t.glyphs.capacity() * sizeof(shaped_text::glyph);
+				});
+		}
+		static void decode(std::wstring_view str, std::u32string& code_points)
+		{
+			code_points.clear();
+			for (size_t i = 0; i < str.length(); i++)
+			{
+				char32_t c = static_cast<char32_t>(str[i]);
+				if constexpr (sizeof(wchar_t) == 2)
+					if (c >= 0xD800 && c < 0xDC00 && i + 1 < str.length())
+					{
+						char32_t low = static_cast<char32_t>(str[i + 1]);
+						if (low >= 0xDC00 && low < 0xE000)
+						{
+							c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+							i++;
+						}
+					}
+				code_points.push_back(c);
+			}
+		}
+
+		void fill_device_rect(real x0, real y0, real x1, real y1, std::uint32_t src)
+		{
+			const auto& clip = clips.back();
+			x0 = std::max(x0, static_cast<real>(clip.left));
+			y0 = std::max(y0, static_cast<real>(clip.top));
+			x1 = std::min(x1, static_cast<real>(clip.right));
+			y1 = std::min(y1, static_cast<real>(clip.bottom));
+			if (!(x0 < x1 && y0 < y1))
+				return;
+			int ix0 = static_cast<int>(std::floor(x0));
+			int iy0 = static_cast<int>(std::floor(y0));
+			int ix1 = static_cast<int>(std::ceil(x1));
+			int iy1 = static_cast<int>(std::ceil(y1));
+			real cover_left = ix0 + 1 - x0;
+			real cover_right = x1 - (ix1 - 1);
+			for (int y = iy0; y < iy1; y++)
+			{
+				real cover_y = std::min<real>(y + 1, y1) - std::max<real>(y, y0);
+				auto p = row(y);
+				if (ix1 - ix0 == 1)
+				{
+					p[ix0] = soft_raster::over(p[ix0],
+						soft_raster::scale(src, soft_raster::to_coverage((x1 - x0) * cover_y)));
+					continue;
+				}
+				p[ix0] = soft_raster::over(p[ix0],
+					soft_raster::scale(src, soft_raster::to_coverage(cover_left * cover_y)));
+				p[ix1 - 1] = soft_raster::over(p[ix1 - 1],
+					soft_raster::scale(src, soft_raster::to_coverage(cover_right * cover_y)));
+				auto c = soft_raster::to_coverage(cover_y);
+				soft_raster::blend_span(p + ix0 + 1, ix1 - ix0 - 2, c == 255 ? src : soft_raster::scale(src, c));
+			}
+		}
+		void fill_ellipse(real x, real y, real rx, real ry, std::uint32_t src)
+		{
+			if (!(src >> 24) || rx <= 0 || ry <= 0)
+				return;
+			if (transform.is_axis_aligned())
+				fill_device_ellipse(transform.transform_x(x, y), transform.transform_y(x, y),
+					std::abs(rx * transform.m11), std::abs(ry * transform.m22), src);
+			else
+				fill_general(x - rx, y - ry, x + rx, y + ry, src, [=](real px, real py)
+					{
+						return ellipse_distance(px - x, py - y, rx, ry);
+					});
+		}
+		void fill_device_ellipse(real ex, real ey, real rx, real ry, std::uint32_t src)
+		{
+			const auto& clip = clips.back();
+			int iy0 = std::max(clip.top, static_cast<int>(std::floor(ey - ry)));
+			int iy1 = std::min(clip.bottom, static_cast<int>(std::ceil(ey + ry)));
+			for (int y = iy0; y < iy1; y++)
+			{
+				real dy = y + 0.5f - ey;
+				real ro = ry + 0.5f;
+				if (std::abs(dy) >= ro)
+					continue;
+				real outer = (rx + 0.5f) * std::sqrt(1 - dy * dy / (ro * ro));
+				real inner = 0;
+				real ri = ry - 0.5f;
+				if (rx > 0.5f && ri > 0 && std::abs(dy) < ri)
+					inner = (rx - 0.5f) * std::sqrt(1 - dy * dy / (ri * ri));
+
+				int xa = std::max(clip.left, static_cast<int>(std::floor(ex - outer)));
+				int xb = std::min(clip.right, static_cast<int>(std::ceil(ex + outer)));
+				int ia = std::clamp(static_cast<int>(std::ceil(ex - inner)), xa, xb);
+				int ib = std::clamp(static_cast<int>(std::floor(ex + inner)), ia, xb);
+				if (inner <= 0)
+					ia = ib = xb;
+				auto p = row(y);
+				auto edge = [&](int x)
+				{
+					real d = ellipse_distance(x + 0.5f - ex, dy, rx, ry);
+					auto c = soft_raster::to_coverage(0.5f - d);
+					if (c)
+						p[x] = soft_raster::over(p[x], c == 255 ? src : soft_raster::scale(src, c));
+				};
+				for (int x = xa; x < ia; x++)
+					edge(x);
+				soft_raster::blend_span(p + ia, ib - ia, src);
+				for (int x = ib; x < xb; x++)
+					edge(x);
+			}
+		}
+		template <typename distance_t>
+		void fill_general(real left, real top, real right, real bottom, std::uint32_t src, distance_t&& distance)
+		{
+			const auto& clip = clips.back();
+			auto [x0, y0, x1, y1] = device_bounds(left, top, right, bottom);
+			int ix0 = std::max(clip.left, static_cast<int>(std::floor(x0)));
+			int iy0 = std::max(clip.top, static_cast<int>(std::floor(y0)));
+			int ix1 = std::min(clip.right, static_cast<int>(std::ceil(x1)));
+			int iy1 = std::min(clip.bottom, static_cast<int>(std::ceil(y1)));
+			auto inv = transform.inverse();
+			real s = std::sqrt(std::abs(transform.determinant()));
+			for (int y = iy0; y < iy1; y++)
+			{
+				auto p = row(y);
+				for (int x = ix0; x < ix1; x++)
+				{
+					real px = x + 0.5f, py = y + 0.5f;
+					real d = distance(inv.transform_x(px, py), inv.transform_y(px, py)) * s;
+					auto c = soft_raster::to_coverage(0.5f - d);
+					if (c)
+						p[x] = soft_raster::over(p[x], c == 255 ? src : soft_raster::scale(src, c));
+				}
+			}
+		}
+		void blit_mask(const unsigned char* mask, int w, int h, int pitch, int x, int y, std::uint32_t src)
+		{
+			const auto& clip = clips.back();
+			int x0 = std::max(x, clip.left);
+			int y0 = std::max(y, clip.top);
+			int x1 = std::min(x + w, clip.right);
+			int y1 = std::min(y + h, clip.bottom);
+			for (int j = y0; j < y1; j++)
+				soft_raster::blend_mask_span(row(j) + x0,
+					mask + static_cast<size_t>(j - y) * pitch + (x0 - x), std::max(0, x1 - x0), src);
+		}
+	};
+}
@@ -0,0 +1,142 @@
+﻿#pragma once
+
+#include <tuple>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <typeinfo>
+#include <stdexcept>
+
+#include "direct_ui.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 子控件的种类与个数在编译期确定的组。子控件同时登记在 widgets 中，布局与输入事件照常处理；
+	/// 合成与命中测试则按子控件的具体类型直接调用 on_paint、paint_opacity 与 on_hittest，不经过虚函数，可以被内联。
+	/// 嵌套的组仍按其自身的方式合成。非组的子控件不应重写 on_compose。
+	/// 限定名调用会跳过更深派生类的重写，因此每个子控件的实际类型必须恰好是 widgets_t 中对应的类型，assign 时检查。
+	/// </summary>
+	/// <typeparam name="widgets_t">子控件的具体类型，按绘制顺序排列。</typeparam>
+	template <typename... widgets_t>
+	class logic_static_group : virtual public logic_group
+	{
+	public:
+		using children_type = std::tuple<std::shared_ptr<widgets_t>...>;
+	protected:
+		children_type _children;
+
+	public:
+		/// <summary>
+		/// 设置子控件，并以同样的顺序替换 widgets。此后不应直接修改 widgets，否则回到逐个虚调用的方式。
+		/// </summary>
+		void assign(std::shared_ptr<widgets_t>... children)
+		{
+			if (!(... && (!children || typeid(*children) == typeid(widgets_t))))
+				throw std::runtime_error("Fail to assign a child whose dynamic type is not exactly its declared type.");
+			_children = children_type(children...);
+			widgets = { children... };
+			invalidate_layout();
+		}
+		template <size_t i>
+		const auto& child() const
+		{
+			return std::get<i>(_children);
+		}
+		/// <summary>
+		/// 以具体类型依次访问各子控件。
+		/// </summary>
+		template <typename visitor_t>
+		void visit(visitor_t&& visitor) const
+		{
+			std::apply([&](const auto&... child)
+				{
+					(visitor(*child), ...);
+				}, _children);
+		}
+		/// <summary>
+		/// widgets 是否仍与 assign 的子控件一致。
+		/// </summary>
+		bool is_static() const
+		{
+			if (widgets.size() != sizeof...(widgets_t))
+				return false;
+			return [&]<size_t... i>(std::index_sequence<i...>)
+			{
+				return ((widgets[i] == std::get<i>(_children)) && ...);
+			}(std::index_sequence_for<widgets_t...>());
+		}
+
+	public:
+		virtual std::shared_ptr<dep_widget_base> hittest(real x, real y) const override
+		{
+			if (!is_static())
+				return logic_group::hittest(x, y);
+			return hittest_from<sizeof...(widgets_t)>(x, y);
+		}
+	private:
+		template <size_t i>
+		std::shared_ptr<dep_widget_base> hittest_from(real x, real y) const
+		{
+			if constexpr (i == 0)
+				return {};
+			else
+			{
+				using widget_t = std::tuple_element_t<i - 1, std::tuple<widgets_t...>>;
+				const auto& widget = std::get<i - 1>(_children);
+				const logic_widget& logic = *widget;
+				if (logic.x() <= x && x < logic.x() + logic.cx() &&
+					logic.y() <= y && y < logic.y() + logic.cy() &&
+					logic.is_visible() &&
+					widget->widget_t::on_hittest(x - logic.x(), y - logic.y()))
+					return widget;
+				return hittest_from<i - 1>(x, y);
+			}
+		}
+	};
+	template <typename... widgets_t>
+	class dep_widget<logic_static_group<widgets_t...>> : virtual public logic_static_group<widgets_t...>, virtual public group
+	{
+	protected:
+		virtual void compose_children(display_list& frame) const override
+		{
+			if (!this->is_static())
+			{
+				group::compose_children(frame);
+				return;
+			}
+			exchange_state(subtree_dirty, false);
+			frame.push_clip(0, 0, cx(), cy());
+			std::apply([&](const auto&... child)
+				{
+					(compose_child(frame, *child), ...);
+				}, this->_children);
+			frame.pop_clip();
+		}
+	private:
+		template <typename widget_t>
+		void compose_child(display_list& frame, widget_t& widget) const
+		{
+			logic_widget& logic = widget;
+			logic._parent = _self;
+			if (widget.widget_t::paint_opacity() <= 0 ||
+				logic.x() >= cx() || logic.y() >= cy() ||
+				logic.x() + logic.cx() <= 0 || logic.y() + logic.cy() <= 0)
+			{
+				frame.composed.culled++;
+				return;
+			}
+			frame.composed.painted++;
+			DIRECT_UI_TRACE_SCOPE("paint", &widget);
+			frame.push_transform(matrix::translation(logic.x(), logic.y()));
+			if constexpr (std::is_base_of_v<logic_group, widget_t>)
+				widget.on_compose(frame);
+			else
+				static_cast<const dep_widget_base&>(widget).compose_with(frame, logic,
+					[&](display_list& dl) { widget.widget_t::on_paint(dl); });
+			frame.pop_transform();
+		}
+	};
+	template <typename... widgets_t>
+	using static_group = dep_widget<logic_static_group<widgets_t...>>;
+}
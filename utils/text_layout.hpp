@@ -0,0 +1,173 @@
+﻿#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+
+#include "direct_ui_types.hpp"
+#include "display_list.hpp"
+#include "resource_cache.hpp"
+#include "code_conv.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 文字排版后的尺寸。
+	/// </summary>
+	struct text_metrics
+	{
+		real width{};
+		real height{};
+		real baseline{};
+	};
+
+	/// <summary>
+	/// 排版缓存的查找键，不持有字符串。
+	/// </summary>
+	struct text_layout_view
+	{
+		std::wstring_view text;
+		size_t text_hash{};
+		text_format format;
+		real width{};
+		real height{};
+
+		text_layout_view(std::wstring_view text, const text_format& format, real width, real height) :
+			text(text), text_hash(std::hash<std::wstring_view>()(text)),
+			format(format), width(width), height(height) {}
+		text_layout_view(std::wstring_view text, size_t text_hash, const text_format& format, real width, real height) :
+			text(text), text_hash(text_hash), format(format), width(width), height(height) {}
+	};
+	/// <summary>
+	/// 排版缓存的键：（字符串哈希，文字格式，排版框大小）。文字或大小变化后自然落到新的键上。
+	/// </summary>
+	struct text_layout_key
+	{
+		std::wstring text;
+		size_t text_hash{};
+		text_format_key format;
+		real width{};
+		real height{};
+
+		text_layout_key(const text_layout_view& v) :
+			text(v.text), text_hash(v.text_hash), format(v.format), width(v.width), height(v.height) {}
+		operator text_layout_view() const
+		{
+			return { text, text_hash, format, width, height };
+		}
+	};
+	struct text_layout_hash
+	{
+		using is_transparent = void;
+		size_t operator()(const text_layout_view& v) const
+		{
+			size_t h = v.text_hash;
+			h ^= text_format_hash()(v.format) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			h ^= std::hash<real>()(v.width) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			h ^= std::hash<real>()(v.height) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			return h;
+		}
+		size_t operator()(const text_layout_key& k) const
+		{
+			return (*this)(static_cast<text_layout_view>(k));
+		}
+	};
+	struct text_layout_equal
+	{
+		using is_transparent = void;
+		static bool equal(const text_layout_view& a, const text_layout_view& b)
+		{
+			return a.text_hash == b.text_hash && a.width == b.width && a.height == b.height &&
+				text_format_equal::equal(a.format, b.format) && a.text == b.text;
+		}
+		template <typename a_t, typename b_t>
+		bool operator()(const a_t& a, const b_t& b) const
+		{
+			return equal(static_cast<text_layout_view>(a), static_cast<text_layout_view>(b));
+		}
+	};
+
+	/// <summary>
+	/// 带字节预算的排版缓存。
+	/// </summary>
+	template <typename layout_t>
+	using text_layout_cache = resource_cache<text_layout_key, layout_t, text_layout_hash, text_layout_equal>;
+
+	/// <summary>
+	/// 字符串在对象之外占用的堆内存。短字符串存放在对象内部，不计入。
+	/// </summary>
+	template <typename char_t>
+	inline size_t heap_footprint(const std::basic_string<char_t>& str)
+	{
+		return str.capacity() > std::basic_string<char_t>().capacity() ? (str.capacity() + 1) * sizeof(char_t) : 0;
+	}
+
+	/// <summary>
+	/// 缓存 UTF-8 文字转换的结果，原文不变时不再转换。不保留原文的副本：把转换结果逐个码点编回 UTF-8 与新的原文比较，
+	/// 完全相同才命中，不分配内存。编不回原文的非法 UTF-8 每次都重新转换。
+	/// </summary>
+	class converted_text
+	{
+		std::wstring converted;
+
+		static bool encodes(std::u8string_view str, std::wstring_view text)
+		{
+			size_t pos = 0;
+			for (size_t i = 0; i < text.size(); i++)
+			{
+				auto c = static_cast<char32_t>(text[i]);
+				if constexpr (sizeof(wchar_t) == sizeof(char16_t))
+					if (c >= 0xD800 && c < 0xDC00 && i + 1 < text.size())
+						c = 0x10000 + ((c - 0xD800) << 10) + (static_cast<char32_t>(text[++i]) - 0xDC00);
+				char8_t bytes[4];
+				size_t length;
+				if (c < 0x80)
+				{
+					bytes[0] = static_cast<char8_t>(c);
+					length = 1;
+				}
+				else if (c < 0x800)
+				{
+					bytes[0] = static_cast<char8_t>(0xC0 | c >> 6);
+					bytes[1] = static_cast<char8_t>(0x80 | (c & 0x3F));
+					length = 2;
+				}
+				else if (c < 0x10000)
+				{
+					bytes[0] = static_cast<char8_t>(0xE0 | c >> 12);
+					bytes[1] = static_cast<char8_t>(0x80 | (c >> 6 & 0x3F));
+					bytes[2] = static_cast<char8_t>(0x80 | (c & 0x3F));
+					length = 3;
+				}
+				else if (c < 0x110000)
+				{
+					bytes[0] = static_cast<char8_t>(0xF0 | c >> 18);
+					bytes[1] = static_cast<char8_t>(0x80 | (c >> 12 & 0x3F));
+					bytes[2] = static_cast<char8_t>(0x80 | (c >> 6 & 0x3F));
+					bytes[3] = static_cast<char8_t>(0x80 | (c & 0x3F));
+					length = 4;
+				}
+				else
+					return false;
+				if (str.size() - pos < length || str.compare(pos, length, bytes, length) != 0)
+					return false;
+				pos += length;
+			}
+			return pos == str.size();
+		}
+
+	public:
+		const std::wstring& operator()(const std::u8string& str)
+		{
+			if (!encodes(str, converted))
+				converted = code_conv<char8_t, wchar_t>::convert(str);
+			return converted;
+		}
+		size_t heap_footprint() const
+		{
+			return direct_ui::heap_footprint(converted);
+		}
+	};
+}
@@ -0,0 +1,168 @@
+﻿#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+#include <concepts>
+#include <utility>
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 工作窃取线程池。每个工作线程从自己队列的前端取任务，队列空时从其他队列的后端窃取。
+	/// run 的调用线程同样参与执行，并在全部任务完成后返回。
+	/// </summary>
+	class work_stealing_pool
+	{
+		struct task_queue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+		std::vector<std::unique_ptr<task_queue>> queues;
+		std::vector<std::thread> workers;
+		// 尚未取走的任务数。任务先入队后计数，先被取走时会暂时为负。
+		std::atomic<std::ptrdiff_t> queued{};
+		std::atomic<size_t> unfinished{};
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::condition_variable done;
+		std::exception_ptr error;
+		bool exit{};
+		// 同一时间只允许一批任务，run 在批次之间串行。
+		std::mutex run_mutex;
+
+		bool pop(size_t index, std::function<void()>& task)
+		{
+			auto& own = *queues[index];
+			{
+				std::lock_guard<std::mutex> lck(own.mutex);
+				if (!own.tasks.empty())
+				{
+					task = std::move(own.tasks.front());
+					own.tasks.pop_front();
+					return true;
+				}
+			}
+			for (size_t i = 1; i < queues.size(); i++)
+			{
+				auto& victim = *queues[(index + i) % queues.size()];
+				std::lock_guard<std::mutex> lck(victim.mutex);
+				if (!victim.tasks.empty())
+				{
+					task = std::move(victim.tasks.back());
+					victim.tasks.pop_back();
+					return true;
+				}
+			}
+			return false;
+		}
+		void execute(std::function<void()>& task)
+		{
+			queued--;
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				if (!error)
+					error = std::current_exception();
+			}
+			task = nullptr;
+			if (--unfinished == 0)
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				done.notify_all();
+			}
+		}
+		void worker_routine(size_t index)
+		{
+			std::function<void()> task;
+			while (true)
+			{
+				if (pop(index, task))
+				{
+					execute(task);
+					continue;
+				}
+				std::unique_lock<std::mutex> lck(mutex);
+				cv.wait(lck, [&] { return exit || queued > 0; });
+				if (exit)
+					return;
+			}
+		}
+
+	public:
+		explicit work_stealing_pool(size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+		{
+			// 调用线程也参与执行，因此只需要 threads - 1 个工作线程。
+			threads = std::max<size_t>(threads, 1);
+			for (size_t i = 0; i < threads; i++)
+				queues.push_back(std::make_unique<task_queue>());
+			for (size_t i = 1; i < threads; i++)
+				workers.emplace_back(&work_stealing_pool::worker_routine, this, i);
+		}
+		work_stealing_pool(const work_stealing_pool&) = delete;
+		work_stealing_pool(work_stealing_pool&&) = delete;
+		work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+		work_stealing_pool& operator=(work_stealing_pool&&) = delete;
+		~work_stealing_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				exit = true;
+			}
+			cv.notify_all();
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+	public:
+		size_t concurrency() const
+		{
+			return queues.size();
+		}
+		/// <summary>
+		/// 对 [0, count) 中的每个下标调用 callback，全部完成后返回。任务抛出的第一个异常在返回时重新抛出。
+		/// </summary>
+		template <typename callback_t>
+		void run(size_t count, callback_t&& callback)
+			requires std::invocable<callback_t&, size_t>
+		{
+			if (!count)
+				return;
+			std::lock_guard<std::mutex> run_lck(run_mutex);
+			unfinished = count;
+			for (size_t i = 0; i < count; i++)
+			{
+				auto& q = *queues[i % queues.size()];
+				std::lock_guard<std::mutex> lck(q.mutex);
+				q.tasks.push_back([&callback, i] { callback(i); });
+			}
+			// 任务全部入队后才公布计数，被唤醒的线程不会面对空队列空转。
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				queued += static_cast<std::ptrdiff_t>(count);
+			}
+			cv.notify_all();
+
+			std::function<void()> task;
+			while (pop(0, task))
+				execute(task);
+			std::unique_lock<std::mutex> lck(mutex);
+			done.wait(lck, [&] { return unfinished == 0; });
+			if (auto e = std::exchange(error, nullptr))
+				std::rethrow_exception(e);
+		}
+	};
+}
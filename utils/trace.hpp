@@ -0,0 +1,248 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <typeinfo>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 一段完整的耗时区间。名字与分类须为静态字符串，例如字面量或 type_info::name()。
+	/// </summary>
+	struct trace_event
+	{
+		const char* category{};
+		const char* name{};
+		const void* instance{};
+		std::int64_t begin{}; // 距追踪器创建的纳秒数。
+		std::int64_t duration{};
+	};
+
+	/// <summary>
+	/// 单个线程的追踪缓冲区。只由所属线程写入，写满后丢弃新事件；
+	/// 导出线程按已发布的数量读取，不需要加锁。
+	/// </summary>
+	class trace_buffer
+	{
+	public:
+		static constexpr size_t capacity = 1 << 16;
+	private:
+		std::unique_ptr<trace_event[]> events{ std::make_unique<trace_event[]>(capacity) };
+		std::atomic<size_t> count{};
+		std::atomic<size_t> _dropped{};
+		std::uint32_t _thread;
+
+	public:
+		explicit trace_buffer(std::uint32_t thread) : _thread(thread) {}
+
+	public:
+		void push(const trace_event& e)
+		{
+			auto n = count.load(std::memory_order_relaxed);
+			if (n == capacity)
+			{
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			events[n] = e;
+			count.store(n + 1, std::memory_order_release);
+		}
+		template <typename callback_t>
+		void for_each(callback_t&& callback) const
+		{
+			auto n = count.load(std::memory_order_acquire);
+			for (size_t i = 0; i < n; i++)
+				callback(events[i]);
+		}
+		void clear()
+		{
+			count.store(0, std::memory_order_release);
+			_dropped.store(0, std::memory_order_relaxed);
+		}
+		size_t size() const { return count.load(std::memory_order_acquire); }
+		size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+		std::uint32_t thread() const { return _thread; }
+	};
+
+	/// <summary>
+	/// 全局追踪器。各线程第一次记录时登记自己的缓冲区，之后的记录不加锁。
+	/// 结果导出为 Chrome 的 trace event JSON，可在 chrome://tracing 或 Perfetto 中打开。
+	/// </summary>
+	class tracer
+	{
+		mutable std::mutex mutex;
+		std::vector<std::unique_ptr<trace_buffer>> buffers;
+		std::atomic<bool> active{};
+		const std::chrono::steady_clock::time_point epoch{ std::chrono::steady_clock::now() };
+
+		tracer() = default;
+		trace_buffer& local_buffer()
+		{
+			thread_local trace_buffer* buffer{};
+			if (!buffer)
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				buffers.push_back(std::make_unique<trace_buffer>(static_cast<std::uint32_t>(buffers.size() + 1)));
+				buffer = buffers.back().get();
+			}
+			return *buffer;
+		}
+		static void write_escaped(std::ostream& os, const char* str)
+		{
+			for (; str && *str; str++)
+			{
+				auto c = static_cast<unsigned char>(*str);
+				if (c == '"' || c == '\\')
+					os << '\\' << *str;
+				else if (c < 0x20)
+				{
+					char buf[8];
+					std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+					os << buf;
+				}
+				else
+					os << *str;
+			}
+		}
+
+	public:
+		tracer(const tracer&) = delete;
+		tracer(tracer&&) = delete;
+		tracer& operator=(const tracer&) = delete;
+		tracer& operator=(tracer&&) = delete;
+		static tracer& instance()
+		{
+			static tracer ret;
+			return ret;
+		}
+
+	public:
+		void start() { active.store(true, std::memory_order_relaxed); }
+		void stop() { active.store(false, std::memory_order_relaxed); }
+		bool is_active() const { return active.load(std::memory_order_relaxed); }
+		std::int64_t now() const
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - epoch).count();
+		}
+		void record(const trace_event& e)
+		{
+			local_buffer().push(e);
+		}
+		/// <summary>
+		/// 清空所有缓冲区。应在 stop 之后、没有线程正在记录时调用。
+		/// </summary>
+		void clear()
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			for (auto& buffer : buffers)
+				buffer->clear();
+		}
+		size_t size() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			size_t ret{};
+			for (const auto& buffer : buffers)
+				ret += buffer->size();
+			return ret;
+		}
+		/// <summary>
+		/// 因缓冲区写满而丢弃的事件数。
+		/// </summary>
+		size_t dropped() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			size_t ret{};
+			for (const auto& buffer : buffers)
+				ret += buffer->dropped();
+			return ret;
+		}
+
+	public:
+		void write_chrome_trace(std::ostream& os) const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+			bool first = true;
+			char buf[96];
+			for (const auto& buffer : buffers)
+				buffer->for_each([&](const trace_event& e)
+					{
+						os << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread() << ",\"cat\":\"";
+						write_escaped(os, e.category);
+						os << "\",\"name\":\"";
+						write_escaped(os, e.name);
+						std::snprintf(buf, sizeof(buf), "\",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"instance\":\"%p\"}}",
+							e.begin / 1000.0, e.duration / 1000.0, e.instance);
+						os << buf;
+						first = false;
+					});
+			os << "\n]}\n";
+		}
+		void save_chrome_trace(const std::string& path) const
+		{
+			std::ofstream fs(path, std::ios::binary);
+			if (!fs)
+				throw std::runtime_error("Fail to open trace file for writing.");
+			write_chrome_trace(fs);
+		}
+	};
+
+	/// <summary>
+	/// 作用域计时。构造时追踪器未启动则什么也不做。
+	/// </summary>
+	class trace_scope
+	{
+		trace_event e;
+		bool active;
+
+	public:
+		trace_scope(const char* category, const char* name, const void* instance = nullptr) :
+			active(tracer::instance().is_active())
+		{
+			if (active)
+				e = { category, name, instance, tracer::instance().now() };
+		}
+		/// <summary>
+		/// 以控件的动态类型命名，以完整对象的地址区分实例。
+		/// </summary>
+		template <typename widget_t>
+			requires std::is_polymorphic_v<widget_t>
+		trace_scope(const char* category, const widget_t* widget) :
+			active(tracer::instance().is_active())
+		{
+			if (active)
+				e = { category, typeid(*widget).name(), dynamic_cast<const void*>(widget), tracer::instance().now() };
+		}
+		trace_scope(const trace_scope&) = delete;
+		trace_scope& operator=(const trace_scope&) = delete;
+		~trace_scope()
+		{
+			if (!active)
+				return;
+			auto& t = tracer::instance();
+			e.duration = t.now() - e.begin;
+			t.record(e);
+		}
+	};
+}
+
+// 定义 DIRECT_UI_TRACE 以启用追踪埋点。未定义时埋点展开为空，参数不会被求值。
+#define DIRECT_UI_TRACE_CONCAT_IMPL(a, b) a##b
+#define DIRECT_UI_TRACE_CONCAT(a, b) DIRECT_UI_TRACE_CONCAT_IMPL(a, b)
+#if DIRECT_UI_TRACE
+#define DIRECT_UI_TRACE_SCOPE(...) \
+	::direct_ui::trace_scope DIRECT_UI_TRACE_CONCAT(direct_ui_trace_scope_, __LINE__)(__VA_ARGS__)
+#else
+#define DIRECT_UI_TRACE_SCOPE(...) ((void)0)
+#endif
@@ -0,0 +1,437 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "direct_ui_types.hpp"
+
+namespace direct_ui
+{
+	class logic_widget;
+
+	/// <summary>
+	/// 缓动曲线，作用于 [0, 1] 的进度。非比例量应使用 linear。
+	/// </summary>
+	enum class easing : std::uint8_t
+	{
+		linear,
+		smooth,
+		ease_out,
+	};
+	inline real apply_easing(easing e, real t)
+	{
+		switch (e)
+		{
+		case easing::smooth:
+			return t * t * (3 - 2 * t);
+		case easing::ease_out:
+			return 1 - (1 - t) * (1 - t);
+		default:
+			return t;
+		}
+	}
+
+	/// <summary>
+	/// 集中推进动画标量的引擎。当前值、目标值、速度、缓动分别存放在连续数组中，
+	/// 每次推进对全部标量做一遍匀速逼近，值有变化的标量使其所属控件重绘。
+	/// 数组按块分配，块的地址不变；推进时发布缓动后的值，读取方不加锁。
+	/// 每个引擎在全局表中占一个编号，句柄只保存编号与槽位。编号 0 为进程共用的引擎，存放尚未进入场景的标量，从不推进。
+	/// </summary>
+	class tween_engine
+	{
+	public:
+		using slot = std::uint32_t;
+		/// <summary>
+		/// 高 8 位为引擎编号，低 24 位为槽位。
+		/// </summary>
+		using address = std::uint32_t;
+	private:
+		static constexpr unsigned slot_bits = 24;
+		static constexpr size_t block_size = 1024; // 4 的倍数，SIMD 推进不跨块。
+		static constexpr size_t max_blocks = 1024;
+		static constexpr size_t max_engines = 256;
+
+		struct block
+		{
+			real current[block_size];
+			real target[block_size];
+			real speed[block_size];
+			easing easings[block_size];
+			logic_widget* owners[block_size];
+			// 发布给读取方的缓动后的值与是否仍在推进，只在持有锁时写入。
+			std::atomic<real> values[block_size];
+			std::atomic<bool> moving[block_size];
+		};
+
+		mutable std::mutex mutex;
+		std::atomic<block*> blocks[max_blocks]{};
+		size_t used{}; // 分配过的槽位数，推进只遍历这些槽位。
+		std::vector<slot> free_slots;
+		size_t live{};
+		size_t _active{};
+		std::function<void()> wake{ [] {} };
+		const std::uint8_t id;
+		// 所有者放弃后，最后一个槽位释放时销毁引擎。
+		bool released{};
+
+		static std::atomic<tween_engine*>* engines()
+		{
+			static std::atomic<tween_engine*> ret[max_engines]{};
+			return ret;
+		}
+		static std::uint8_t register_engine(tween_engine* engine)
+		{
+			static std::mutex registry_mutex;
+			std::lock_guard<std::mutex> lck(registry_mutex);
+			for (size_t i = 1; i < max_engines; i++)
+				if (!engines()[i].load(std::memory_order_relaxed))
+				{
+					engines()[i].store(engine, std::memory_order_release);
+					return static_cast<std::uint8_t>(i);
+				}
+			throw std::runtime_error("Fail to register more tween engines.");
+		}
+
+		explicit tween_engine(std::uint8_t id) : id(id)
+		{
+			engines()[id].store(this, std::memory_order_release);
+		}
+		tween_engine() : id(register_engine(this)) {}
+		~tween_engine()
+		{
+			engines()[id].store(nullptr, std::memory_order_release);
+			for (auto& b : blocks)
+				delete b.load(std::memory_order_relaxed);
+		}
+
+		block& at(slot s) const
+		{
+			return *blocks[s / block_size].load(std::memory_order_acquire);
+		}
+		static void publish(block& b, size_t i)
+		{
+			b.values[i].store(apply_easing(b.easings[i], b.current[i]), std::memory_order_relaxed);
+			b.moving[i].store(b.current[i] != b.target[i], std::memory_order_relaxed);
+		}
+
+	public:
+		tween_engine(const tween_engine&) = delete;
+		tween_engine(tween_engine&&) = delete;
+		tween_engine& operator=(const tween_engine&) = delete;
+		tween_engine& operator=(tween_engine&&) = delete;
+
+		struct releaser
+		{
+			void operator()(tween_engine* engine) const noexcept
+			{
+				engine->release();
+			}
+		};
+		using handle = std::unique_ptr<tween_engine, releaser>;
+		/// <summary>
+		/// 创建引擎并登记编号，由场景持有。
+		/// </summary>
+		static handle create()
+		{
+			return handle(new tween_engine);
+		}
+		/// <summary>
+		/// 进程共用的引擎，不属于任何场景，不会销毁。
+		/// </summary>
+		static tween_engine& detached()
+		{
+			static tween_engine* ret = new tween_engine(0);
+			return *ret;
+		}
+		static tween_engine& of(address a)
+		{
+			return *engines()[a >> slot_bits].load(std::memory_order_acquire);
+		}
+		static slot slot_of(address a)
+		{
+			return a & ((address(1) << slot_bits) - 1);
+		}
+		bool is_detached() const
+		{
+			return id == 0;
+		}
+		/// <summary>
+		/// 所有者放弃引擎。控件可能比场景活得久，仍有槽位时在最后一个槽位释放后销毁。
+		/// </summary>
+		void release() noexcept
+		{
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				released = true;
+				wake = [] {};
+				if (live)
+					return;
+			}
+			delete this;
+		}
+
+	public:
+		/// <summary>
+		/// 目标值改变、需要开始推进时调用。
+		/// </summary>
+		void set_wake(std::function<void()> callback)
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			wake = callback ? std::move(callback) : [] {};
+		}
+		address allocate(logic_widget* owner, real value, real units_per_second, easing e)
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			slot ret;
+			if (!free_slots.empty())
+			{
+				ret = free_slots.back();
+				free_slots.pop_back();
+			}
+			else
+			{
+				if (used == block_size * max_blocks)
+					throw std::runtime_error("Fail to allocate more tween slots.");
+				if (used % block_size == 0)
+					blocks[used / block_size].store(new block(), std::memory_order_release);
+				ret = static_cast<slot>(used++);
+			}
+			live++;
+			auto& b = at(ret);
+			size_t i = ret % block_size;
+			b.current[i] = b.target[i] = value;
+			b.speed[i] = units_per_second;
+			b.easings[i] = e;
+			b.owners[i] = owner;
+			publish(b, i);
+			return static_cast<address>(id) << slot_bits | ret;
+		}
+		void deallocate(slot s) noexcept
+		{
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				auto& b = at(s);
+				size_t i = s % block_size;
+				b.target[i] = b.current[i];
+				b.speed[i] = 0;
+				b.owners[i] = nullptr;
+				free_slots.push_back(s);
+				if (--live || !released)
+					return;
+			}
+			delete this;
+		}
+		void set_target(slot s, real value)
+		{
+			std::function<void()> callback;
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				auto& b = at(s);
+				size_t i = s % block_size;
+				if (b.target[i] == value)
+					return;
+				b.target[i] = value;
+				publish(b, i);
+				callback = wake;
+			}
+			callback();
+		}
+		/// <summary>
+		/// 不经过动画，直接设为 value。
+		/// </summary>
+		void jump(slot s, real value)
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			auto& b = at(s);
+			size_t i = s % block_size;
+			b.current[i] = b.target[i] = value;
+			publish(b, i);
+		}
+		/// <summary>
+		/// 最近一次发布的缓动后的值，不加锁。
+		/// </summary>
+		real value(slot s) const
+		{
+			return at(s).values[s % block_size].load(std::memory_order_relaxed);
+		}
+		bool is_active(slot s) const
+		{
+			return at(s).moving[s % block_size].load(std::memory_order_relaxed);
+		}
+		struct parameters
+		{
+			real value; // 未经缓动的当前值。
+			real units_per_second;
+			easing e;
+		};
+		/// <summary>
+		/// 复制句柄或迁移到其他引擎时使用。
+		/// </summary>
+		parameters parameters_of(slot s) const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			auto& b = at(s);
+			size_t i = s % block_size;
+			return { b.current[i], b.speed[i], b.easings[i] };
+		}
+		size_t size() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			return live;
+		}
+		size_t active_count() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			return _active;
+		}
+
+	public:
+		/// <summary>
+		/// 推进 dt 秒。对值有变化的标量的所属控件调用 on_changed（持有锁，不应再访问引擎）。
+		/// 返回仍未到达目标的标量个数。
+		/// </summary>
+		template <typename callback_t>
+		size_t advance(real dt, callback_t&& on_changed)
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			size_t active = 0;
+			for (size_t first = 0; first < used; first += block_size)
+			{
+				auto& b = at(static_cast<slot>(first));
+				size_t n = std::min(block_size, used - first);
+				size_t i = 0;
+				real* c = b.current;
+				const real* t = b.target;
+				const real* v = b.speed;
+#if DIRECT_UI_SSE2
+				const __m128 step = _mm_set1_ps(dt);
+				const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+				for (; i + 4 <= n; i += 4)
+				{
+					__m128 c4 = _mm_loadu_ps(c + i);
+					__m128 t4 = _mm_loadu_ps(t + i);
+					__m128 s4 = _mm_mul_ps(_mm_loadu_ps(v + i), step);
+					__m128 d4 = _mm_sub_ps(t4, c4);
+					// 剩余距离不超过一步时直接落到目标上，否则朝目标移动一步。
+					__m128 reach = _mm_cmple_ps(_mm_and_ps(d4, abs_mask), s4);
+					__m128 signed_step = _mm_or_ps(_mm_andnot_ps(abs_mask, d4), s4);
+					__m128 next = _mm_or_ps(_mm_and_ps(reach, t4), _mm_andnot_ps(reach, _mm_add_ps(c4, signed_step)));
+					int moving = _mm_movemask_ps(_mm_cmpneq_ps(next, t4));
+					active += (moving & 1) + (moving >> 1 & 1) + (moving >> 2 & 1) + (moving >> 3 & 1);
+					int changed = _mm_movemask_ps(_mm_cmpneq_ps(next, c4));
+					if (!changed)
+						continue;
+					_mm_storeu_ps(c + i, next);
+					for (int k = 0; k < 4; k++)
+						if (changed >> k & 1)
+						{
+							publish(b, i + k);
+							on_changed(b.owners[i + k]);
+						}
+				}
+#endif
+				for (; i < n; i++)
+				{
+					if (c[i] == t[i])
+						continue;
+					real d = t[i] - c[i];
+					real s = v[i] * dt;
+					real next = std::abs(d) <= s ? t[i] : c[i] + std::copysign(s, d);
+					active += next != t[i];
+					if (next == c[i])
+						continue;
+					c[i] = next;
+					publish(b, i);
+					on_changed(b.owners[i]);
+				}
+			}
+			_active = active;
+			return active;
+		}
+	};
+
+	/// <summary>
+	/// 控件持有的动画标量句柄，只保存引擎编号与槽位，初始值、速度与缓动都存放在引擎中。
+	/// 构造时存放在进程共用的引擎里，第一次设置目标时迁移到所属场景的引擎；
+	/// 控件不在场景中时，设置目标直接生效。复制得到的句柄只继承当前值。读取值不加锁。
+	/// </summary>
+	class tween
+	{
+		tween_engine::address a;
+
+		tween_engine& engine() const
+		{
+			return tween_engine::of(a);
+		}
+		tween_engine::slot s() const
+		{
+			return tween_engine::slot_of(a);
+		}
+
+	public:
+		/// <param name="value">初始值。</param>
+		/// <param name="units_per_second">每秒变化量。</param>
+		tween(real value = 0, real units_per_second = 5, easing e = easing::linear) :
+			a(tween_engine::detached().allocate(nullptr, value, units_per_second, e)) {}
+		tween(const tween& another)
+		{
+			auto p = another.engine().parameters_of(another.s());
+			a = tween_engine::detached().allocate(nullptr, p.value, p.units_per_second, p.e);
+		}
+		tween& operator=(const tween& another)
+		{
+			if (this != &another)
+				jump_to(another.engine().parameters_of(another.s()).value);
+			return *this;
+		}
+		~tween()
+		{
+			engine().deallocate(s());
+		}
+
+	public:
+		/// <summary>
+		/// 以 owner 所在场景的引擎向 value 推进。
+		/// </summary>
+		template <typename owner_t>
+		void animate_to(owner_t& owner, real value)
+		{
+			if (engine().is_detached())
+			{
+				auto target = owner.tweens();
+				if (!target)
+				{
+					jump_to(value);
+					return;
+				}
+				auto p = engine().parameters_of(s());
+				auto moved = target->allocate(&owner, p.value, p.units_per_second, p.e);
+				engine().deallocate(s());
+				a = moved;
+			}
+			engine().set_target(s(), value);
+		}
+		void jump_to(real value)
+		{
+			engine().jump(s(), value);
+		}
+		/// <summary>
+		/// 经过缓动的值。
+		/// </summary>
+		real value() const
+		{
+			return engine().value(s());
+		}
+		bool is_active() const
+		{
+			return engine().is_active(s());
+		}
+	};
+}
@@ -0,0 +1,409 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "direct_ui.hpp"
+
+namespace direct_ui
+{
+	/// <summary>
+	/// 可修改单项的前缀和（树状数组）。用于由滚动位置查找行号，以及由行号求行的位置，均为 O(log n)。
+	/// </summary>
+	class prefix_sum_index
+	{
+		std::vector<double> tree; // 下标从 1 开始。
+		std::vector<real> values;
+
+	public:
+		/// <summary>
+		/// 重置为 count 项，每项为 value。O(n)。
+		/// </summary>
+		void assign(size_t count, real value)
+		{
+			values.assign(count, value);
+			tree.assign(count + 1, 0);
+			for (size_t i = 1; i <= count; i++)
+			{
+				tree[i] += value;
+				if (size_t j = i + (i & (~i + 1)); j <= count)
+					tree[j] += tree[i];
+			}
+		}
+		size_t size() const
+		{
+			return values.size();
+		}
+		real operator[](size_t i) const
+		{
+			return values[i];
+		}
+		void set(size_t i, real value)
+		{
+			double delta = static_cast<double>(value) - values[i];
+			values[i] = value;
+			for (size_t j = i + 1; j < tree.size(); j += j & (~j + 1))
+				tree[j] += delta;
+		}
+		/// <summary>
+		/// 前 count 项之和。
+		/// </summary>
+		double prefix(size_t count) const
+		{
+			double ret{};
+			for (size_t j = count; j; j -= j & (~j + 1))
+				ret += tree[j];
+			return ret;
+		}
+		double total() const
+		{
+			return prefix(values.size());
+		}
+		/// <summary>
+		/// 包含位置 offset 的项，即满足 prefix(i) <= offset 的最大 i。offset 超出总和时返回 size()。
+		/// </summary>
+		size_t find(double offset) const
+		{
+			size_t pos = 0;
+			size_t step = 1;
+			while (step * 2 <= values.size())
+				step *= 2;
+			for (; step; step /= 2)
+				if (pos + step <= values.size() && tree[pos + step] <= offset)
+				{
+					pos += step;
+					offset -= tree[pos];
+				}
+			return pos;
+		}
+		size_t heap_footprint() const
+		{
+			return tree.capacity() * sizeof(tree[0]) + values.capacity() * sizeof(values[0]);
+		}
+	};
+
+	/// <summary>
+	/// 虚拟列表的数据源。列表只为可见的条目向数据源请求内容。
+	/// </summary>
+	class list_data_source
+	{
+	public:
+		virtual ~list_data_source() {}
+
+	public:
+		virtual size_t size() const = 0;
+		/// <summary>
+		/// 创建一个条目控件。条目控件会被回收，并反复绑定到不同的条目上。
+		/// </summary>
+		virtual std::shared_ptr<dep_widget_base> create_item() = 0;
+		/// <summary>
+		/// 把条目控件绑定到第 index 个条目。
+		/// </summary>
+		virtual void bind(dep_widget_base& item, size_t index) = 0;
+		/// <summary>
+		/// 条目控件滚出可见区域、即将回收时调用。
+		/// </summary>
+		virtual void unbind(dep_widget_base& item, size_t index) {}
+	};
+
+	/// <summary>
+	/// 虚拟列表。只有可见的条目（及上下各 overscan 像素内的条目）持有控件，滚出的控件放回回收池，
+	/// 因此控件数与每帧的开销只取决于可见区域的大小。columns 大于 1 时按行排列成网格。
+	/// 行高可变：未显示过的行按估计高度计，绑定时以条目的 on_measure 结果修正，行的位置由前缀和求得。
+	/// </summary>
+	class logic_virtual_list : virtual public logic_group
+	{
+	public:
+		struct statistics
+		{
+			size_t realized{}; // 当前持有控件的条目数。
+			size_t pooled{};
+			size_t created{}; // 累计创建的条目控件数。
+			size_t bound{}; // 累计绑定次数。
+		};
+	private:
+		struct realized_item
+		{
+			size_t index;
+			std::shared_ptr<dep_widget_base> widget;
+			real height; // 按列宽测量的高度。
+		};
+		std::shared_ptr<list_data_source> source;
+		size_t _columns{ 1 };
+		real _estimated_height{ 32 };
+		real _overscan{ 64 };
+		prefix_sum_index heights;
+		std::vector<realized_item> items; // 按条目下标排序，与 widgets 的顺序一致。
+		std::vector<realized_item> next_items;
+		std::vector<std::shared_ptr<dep_widget_base>> pool;
+		double scroll{};
+		real column_width{};
+		// 滚动锚点：可见区域顶端所在的行，以及顶端相对该行的偏移。行高被修正后保持锚点不动。
+		size_t anchor_row{};
+		double anchor_delta{};
+		bool at_end{}; // 滚动到底时保持在底端。
+		statistics stats;
+
+		size_t row_count() const
+		{
+			return source ? (source->size() + _columns - 1) / _columns : 0;
+		}
+		void set_anchor()
+		{
+			anchor_row = heights.find(scroll);
+			anchor_delta = anchor_row < heights.size() ? scroll - heights.prefix(anchor_row) : 0;
+			at_end = scroll > 0 && scroll >= max_scroll();
+		}
+		double max_scroll() const
+		{
+			return std::max(0.0, heights.total() - cy());
+		}
+		void recycle(realized_item& item)
+		{
+			source->unbind(*item.widget, item.index);
+			pool.push_back(std::move(item.widget));
+		}
+		/// <summary>
+		/// 取一个条目控件并绑定到第 index 个条目。
+		/// </summary>
+		void realize(size_t index)
+		{
+			std::shared_ptr<dep_widget_base> widget;
+			if (!pool.empty())
+			{
+				widget = std::move(pool.back());
+				pool.pop_back();
+			}
+			else
+			{
+				widget = source->create_item();
+				stats.created++;
+			}
+			source->bind(*widget, index);
+			stats.bound++;
+			auto height = to_logic_ref(widget)->on_measure({ column_width, layout_size::unbounded }).cy;
+			next_items.push_back({ index, std::move(widget), height });
+		}
+		/// <summary>
+		/// 用已绑定条目的高度修正行高，行高取同行条目中最高者。返回是否有行高改变。
+		/// </summary>
+		bool update_heights()
+		{
+			bool changed{};
+			for (size_t i = 0; i < items.size();)
+			{
+				size_t row = items[i].index / _columns;
+				real height{};
+				for (; i < items.size() && items[i].index / _columns == row; i++)
+					height = std::max(height, items[i].height);
+				if (heights[row] != height)
+				{
+					heights.set(row, height);
+					changed = true;
+				}
+			}
+			return changed;
+		}
+
+	public:
+		void set_data_source(std::shared_ptr<list_data_source> data_source)
+		{
+			for (auto& item : items)
+				recycle(item);
+			items.clear();
+			pool.clear();
+			source = std::move(data_source);
+			reload();
+		}
+		const std::shared_ptr<list_data_source>& get_data_source() const
+		{
+			return source;
+		}
+		/// <summary>
+		/// 数据整体变化后调用。所有行回到估计高度，滚动回到顶端。
+		/// </summary>
+		void reload()
+		{
+			for (auto& item : items)
+				recycle(item);
+			items.clear();
+			heights.assign(row_count(), _estimated_height);
+			scroll = 0;
+			set_anchor();
+			invalidate_arrange();
+		}
+		/// <summary>
+		/// 第 index 个条目的内容变化后调用。只在它可见时重新绑定。
+		/// </summary>
+		void refresh(size_t index)
+		{
+			auto it = std::lower_bound(items.begin(), items.end(), index,
+				[](const realized_item& item, size_t index) { return item.index < index; });
+			if (it == items.end() || it->index != index)
+				return;
+			recycle(*it);
+			items.erase(it);
+			invalidate_arrange();
+		}
+		void set_columns(size_t columns)
+		{
+			_columns = std::max<size_t>(columns, 1);
+			reload();
+		}
+		size_t columns() const
+		{
+			return _columns;
+		}
+		void set_estimated_row_height(real height)
+		{
+			_estimated_height = height;
+			reload();
+		}
+		/// <summary>
+		/// 可见区域上下额外准备的像素数。
+		/// </summary>
+		void set_overscan(real overscan)
+		{
+			_overscan = overscan;
+			invalidate_arrange();
+		}
+
+	public:
+		double scroll_offset() const
+		{
+			return scroll;
+		}
+		/// <summary>
+		/// 按当前已知的行高计算的内容总高度。
+		/// </summary>
+		double content_height() const
+		{
+			return heights.total();
+		}
+		void scroll_to(double offset)
+		{
+			offset = std::clamp(offset, 0.0, max_scroll());
+			if (offset == scroll)
+				return;
+			scroll = offset;
+			set_anchor();
+			invalidate_arrange();
+		}
+		void scroll_by(double delta)
+		{
+			scroll_to(scroll + delta);
+		}
+		/// <summary>
+		/// 滚动到使第 index 个条目完整可见的最近位置。
+		/// </summary>
+		void scroll_into_view(size_t index)
+		{
+			size_t row = index / _columns;
+			if (row >= heights.size())
+				return;
+			double top = heights.prefix(row);
+			double bottom = top + heights[row];
+			if (top < scroll)
+				scroll_to(top);
+			else if (bottom > scroll + cy())
+				scroll_to(bottom - cy());
+		}
+		/// <summary>
+		/// 第 index 个条目当前的控件。不可见时为空。
+		/// </summary>
+		std::shared_ptr<dep_widget_base> item_widget(size_t index) const
+		{
+			auto it = std::lower_bound(items.begin(), items.end(), index,
+				[](const realized_item& item, size_t index) { return item.index < index; });
+			return it != items.end() && it->index == index ? it->widget : nullptr;
+		}
+		statistics get_statistics() const
+		{
+			auto ret = stats;
+			ret.realized = items.size();
+			ret.pooled = pool.size();
+			return ret;
+		}
+
+	protected:
+		virtual void on_arrange(layout_size size) override
+		{
+			if (!source)
+				return;
+			size_t count = source->size();
+			if (column_width != size.cx / _columns)
+			{
+				column_width = size.cx / _columns;
+				for (auto& item : items)
+					item.height = to_logic_ref(item.widget)->on_measure({ column_width, layout_size::unbounded }).cy;
+			}
+			// 新绑定的行可能改变行高，按锚点修正滚动位置后再求一次可见范围。
+			for (int pass = 0; pass < 4; pass++)
+			{
+				if (at_end)
+					scroll = max_scroll();
+				else if (anchor_row < heights.size())
+					scroll = heights.prefix(anchor_row) + anchor_delta;
+				scroll = std::clamp(scroll, 0.0, max_scroll());
+				size_t first = heights.find(scroll - _overscan) * _columns;
+				size_t last = std::min(count, (heights.find(scroll + size.cy + _overscan) + 1) * _columns);
+				// 先回收滚出的条目，新条目才能复用它们的控件。
+				std::erase_if(items, [&](realized_item& item)
+					{
+						if (item.index >= first && item.index < last)
+							return false;
+						recycle(item);
+						return true;
+					});
+				next_items.clear();
+				auto it = items.begin();
+				for (size_t index = first; index < last; index++)
+				{
+					if (it != items.end() && it->index == index)
+						next_items.push_back(std::move(*it++));
+					else
+						realize(index);
+				}
+				items.swap(next_items);
+				if (!update_heights())
+					break;
+			}
+			next_items.clear();
+			set_anchor();
+
+			bool membership_changed = widgets.size() != items.size();
+			for (size_t i = 0; !membership_changed && i < items.size(); i++)
+				membership_changed = widgets[i] != items[i].widget;
+			if (membership_changed)
+			{
+				widgets.clear();
+				for (const auto& item : items)
+					widgets.push_back(item.widget);
+				invalidate();
+			}
+			for (const auto& item : items)
+			{
+				size_t row = item.index / _columns;
+				place_child(*to_logic_ref(item.widget), { column_width * static_cast<real>(item.index % _columns),
+					static_cast<real>(heights.prefix(row) - scroll), column_width, heights[row] });
+			}
+		}
+
+	public:
+		virtual size_t heap_footprint() const override
+		{
+			return logic_group::heap_footprint() + heights.heap_footprint() +
+				(items.capacity() + next_items.capacity()) * sizeof(realized_item) +
+				pool.capacity() * sizeof(pool[0]);
+		}
+	};
+	template <>
+	class dep_widget<logic_virtual_list> : virtual public logic_virtual_list, virtual public dep_widget<logic_group>
+	{
+	};
+	using virtual_list = dep_widget<logic_virtual_list>;
+	static_assert(has_implimented_dep_widget<logic_virtual_list>);
+}
@@ -0,0 +1,271 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+namespace direct_ui
+{
+	struct pool_statistics
+	{
+		size_t allocations{};
+		size_t deallocations{};
+		size_t live{};
+		size_t slabs{}; // 向系统申请的块数。
+		size_t large_allocations{}; // 超出尺寸分级、直接向系统申请的次数。
+		size_t reserved_bytes{};
+	};
+
+	/// <summary>
+	/// 按尺寸分级的块池。小对象从 64 KiB 的大块中顺序切出，释放后挂在对应级别的空闲链表上复用；
+	/// 大块只在池销毁时整体归还系统。创建池的线程不加锁，其他线程（计时器线程、工作线程）经互斥锁访问另一组空闲链表。
+	/// 池由 create 创建、由所有者以 release 放弃，最后一个块释放后自行销毁，控件因此可以比场景活得久。
+	/// </summary>
+	class widget_pool
+	{
+		static constexpr size_t granularity = 16;
+		static constexpr size_t max_small = 2048;
+		static constexpr size_t slab_size = 64 * 1024;
+
+		struct free_block
+		{
+			free_block* next;
+		};
+		/// <summary>
+		/// 一组空闲链表与切分中的大块，只由一个线程或在锁内使用。
+		/// </summary>
+		struct arena
+		{
+			free_block* free_lists[max_small / granularity]{};
+			std::vector<std::unique_ptr<std::byte[]>> slabs;
+			std::byte* cursor{};
+			std::byte* end{};
+			std::atomic<size_t> slab_count{}; // 只由使用者修改，statistics 可能在其他线程读取。
+
+			void* take(size_t c)
+			{
+				if (auto p = free_lists[c - 1])
+				{
+					free_lists[c - 1] = p->next;
+					return p;
+				}
+				size_t rounded = c * granularity;
+				if (static_cast<size_t>(end - cursor) < rounded)
+				{
+					slabs.push_back(std::make_unique_for_overwrite<std::byte[]>(slab_size));
+					cursor = slabs.back().get();
+					end = cursor + slab_size;
+					slab_count.store(slabs.size(), std::memory_order_relaxed);
+				}
+				auto ret = cursor;
+				cursor += rounded;
+				return ret;
+			}
+			void give(void* p, size_t c) noexcept
+			{
+				auto block = static_cast<free_block*>(p);
+				block->next = free_lists[c - 1];
+				free_lists[c - 1] = block;
+			}
+		};
+		/// <summary>
+		/// 计数只由一个线程或在锁内修改，statistics 可能在其他线程读取，因此用原子量但不做读改写。
+		/// </summary>
+		struct counters
+		{
+			std::atomic<size_t> allocations{};
+			std::atomic<size_t> deallocations{};
+			std::atomic<size_t> large_allocations{};
+
+			static void bump(std::atomic<size_t>& counter) noexcept
+			{
+				counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+		};
+
+		const std::thread::id owner{ std::this_thread::get_id() };
+		arena local; // 只由所有者线程使用。
+		counters local_counters;
+		mutable std::mutex mutex;
+		arena shared; // 其他线程在锁内使用。
+		counters shared_counters;
+		// 所有者放弃后所有访问都经过锁，最后一个块释放时销毁池。
+		bool released{};
+
+		widget_pool() = default;
+		~widget_pool() = default;
+
+		static size_t size_class(size_t bytes)
+		{
+			return (bytes + granularity - 1) / granularity;
+		}
+		static bool is_small(size_t bytes, size_t align)
+		{
+			return bytes && bytes <= max_small && align <= granularity;
+		}
+		bool is_owner_thread() const
+		{
+			return !released && std::this_thread::get_id() == owner;
+		}
+		size_t live() const
+		{
+			return local_counters.allocations.load(std::memory_order_relaxed) + shared_counters.allocations.load(std::memory_order_relaxed) -
+				local_counters.deallocations.load(std::memory_order_relaxed) - shared_counters.deallocations.load(std::memory_order_relaxed);
+		}
+
+	public:
+		widget_pool(const widget_pool&) = delete;
+		widget_pool(widget_pool&&) = delete;
+		widget_pool& operator=(const widget_pool&) = delete;
+		widget_pool& operator=(widget_pool&&) = delete;
+
+		struct releaser
+		{
+			void operator()(widget_pool* pool) const noexcept
+			{
+				pool->release();
+			}
+		};
+		using handle = std::unique_ptr<widget_pool, releaser>;
+		/// <summary>
+		/// 创建池，调用线程成为所有者线程。
+		/// </summary>
+		static handle create()
+		{
+			return handle(new widget_pool);
+		}
+		/// <summary>
+		/// 所有者放弃池。没有存活的块时立即整体归还所有大块，否则在最后一个块释放时归还。
+		/// 调用时所有者线程上不应再有并发的分配或释放。
+		/// </summary>
+		void release() noexcept
+		{
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				released = true;
+				if (live())
+					return;
+			}
+			delete this;
+		}
+
+	public:
+		void* allocate(size_t bytes, size_t align)
+		{
+			bool small = is_small(bytes, align);
+			if (is_owner_thread())
+			{
+				counters::bump(local_counters.allocations);
+				if (small)
+					return local.take(size_class(bytes));
+				counters::bump(local_counters.large_allocations);
+				return ::operator new(bytes, std::align_val_t{ align });
+			}
+			std::lock_guard<std::mutex> lck(mutex);
+			counters::bump(shared_counters.allocations);
+			if (small)
+				return shared.take(size_class(bytes));
+			counters::bump(shared_counters.large_allocations);
+			return ::operator new(bytes, std::align_val_t{ align });
+		}
+		void deallocate(void* p, size_t bytes, size_t align) noexcept
+		{
+			bool small = is_small(bytes, align);
+			if (!small)
+				::operator delete(p, std::align_val_t{ align });
+			if (is_owner_thread())
+			{
+				counters::bump(local_counters.deallocations);
+				if (small)
+					local.give(p, size_class(bytes));
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lck(mutex);
+				counters::bump(shared_counters.deallocations);
+				// 放弃后不再复用，大块在池销毁时一并归还。
+				if (!released)
+				{
+					if (small)
+						shared.give(p, size_class(bytes));
+					return;
+				}
+				if (live())
+					return;
+			}
+			delete this;
+		}
+		pool_statistics statistics() const
+		{
+			std::lock_guard<std::mutex> lck(mutex);
+			pool_statistics ret;
+			ret.allocations = local_counters.allocations.load(std::memory_order_relaxed) + shared_counters.allocations.load(std::memory_order_relaxed);
+			ret.deallocations = local_counters.deallocations.load(std::memory_order_relaxed) + shared_counters.deallocations.load(std::memory_order_relaxed);
+			ret.live = ret.allocations - ret.deallocations;
+			ret.large_allocations = local_counters.large_allocations.load(std::memory_order_relaxed) + shared_counters.large_allocations.load(std::memory_order_relaxed);
+			ret.slabs = local.slab_count.load(std::memory_order_relaxed) + shared.slab_count.load(std::memory_order_relaxed);
+			ret.reserved_bytes = ret.slabs * slab_size;
+			return ret;
+		}
+	};
+
+	/// <summary>
+	/// 从 widget_pool 分配的分配器，供 std::allocate_shared 使用。控制块中只保存池的指针，
+	/// 池在最后一个块释放之后才销毁，见 widget_pool::release。
+	/// </summary>
+	template <typename T>
+	class pool_allocator
+	{
+		template <typename U>
+		friend class pool_allocator;
+		widget_pool* pool;
+
+	public:
+		using value_type = T;
+		pool_allocator(widget_pool* pool) noexcept : pool(pool) {}
+		template <typename U>
+		pool_allocator(const pool_allocator<U>& another) noexcept : pool(another.pool) {}
+
+	public:
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(pool->allocate(n * sizeof(T), alignof(T)));
+		}
+		void deallocate(T* p, size_t n) noexcept
+		{
+			pool->deallocate(p, n * sizeof(T), alignof(T));
+		}
+		template <typename U>
+		bool operator==(const pool_allocator<U>& another) const noexcept
+		{
+			return pool == another.pool;
+		}
+	};
+
+	/// <summary>
+	/// 不持有所有权的控件句柄，复制时没有原子操作。只在确定控件由树或其他 shared_ptr 保持存活的单线程代码中使用。
+	/// </summary>
+	template <typename T>
+	class widget_ref
+	{
+		T* p{};
+
+	public:
+		widget_ref() = default;
+		widget_ref(T* p) noexcept : p(p) {}
+		template <typename U>
+		widget_ref(const std::shared_ptr<U>& ptr) noexcept : p(ptr.get()) {}
+
+	public:
+		T* get() const noexcept { return p; }
+		T* operator->() const noexcept { return p; }
+		T& operator*() const noexcept { return *p; }
+		explicit operator bool() const noexcept { return p; }
+		bool operator==(const widget_ref&) const = default;
+	};
+}